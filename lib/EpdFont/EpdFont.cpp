@@ -1,12 +1,20 @@
 #include "EpdFont.h"
+#include "EpdFontFamily.h"
 
 #include <Utf8.h>
 
 #include <algorithm>
+#include <cstdlib>
+
+EpdFont::~EpdFont() {
+  free(directGlyphs.load());
+  free(directKernClasses.load());
+}
 
 void EpdFont::getTextBounds(const char *string, const int startX,
                             const int startY, int *minX, int *minY, int *maxX,
-                            int *maxY) const {
+                            int *maxY, const EpdFontFamily *family,
+                            const uint8_t style) const {
   *minX = startX;
   *minY = startY;
   *maxX = startX;
@@ -32,7 +40,16 @@ void EpdFont::getTextBounds(const char *string, const int startX,
       cp = applyLigatures(cp, string);
     }
 
-    const EpdGlyph *glyph = getGlyph(cp);
+    EpdFontFamily::ResolvedGlyph resolved;
+    if (family) {
+      resolved =
+          family->resolveGlyph(cp, static_cast<EpdFontFamily::Style>(style));
+    } else {
+      resolved.font = this;
+      resolved.glyph = getGlyph(cp, &resolved.index);
+    }
+    const EpdFont *font = resolved.font;
+    const EpdGlyph *glyph = resolved.glyph;
     if (!glyph) {
       // Keep cursor movement stable when a base glyph is missing, but don't
       // attach subsequent combining marks to stale base metrics.
@@ -48,10 +65,11 @@ void EpdFont::getTextBounds(const char *string, const int startX,
       continue;
     }
 
+    const EpdGlyphBounds box = font->getBounds(glyph, resolved.index);
     const int raiseBy =
-        isCombining ? combiningMark::raiseAboveBase(glyph->top, glyph->height,
-                                                    lastBaseTop)
-                    : 0;
+        isCombining
+            ? combiningMark::raiseAboveBase(box.top, box.height, lastBaseTop)
+            : 0;
 
     if (!isCombining && prevCp != 0) {
       const auto kernFP = getKerning(prevCp, cp); // 4.4 fixed-point kern
@@ -61,20 +79,21 @@ void EpdFont::getTextBounds(const char *string, const int startX,
     const int glyphBaseX =
         isCombining
             ? combiningMark::centerOver(lastBaseX, lastBaseLeft, lastBaseWidth,
-                                        glyph->left, glyph->width)
+                                        box.left, box.width)
             : lastBaseX;
     const int glyphBaseY = startY - raiseBy;
 
-    *minX = std::min(*minX, glyphBaseX + glyph->left);
-    *maxX = std::max(*maxX, glyphBaseX + glyph->left + glyph->width);
-    *minY = std::min(*minY, glyphBaseY + glyph->top - glyph->height);
-    *maxY = std::max(*maxY, glyphBaseY + glyph->top);
+    *minX = std::min(*minX, glyphBaseX + box.left);
+    *maxX = std::max(*maxX, glyphBaseX + box.left + box.width);
+    *minY = std::min(*minY, glyphBaseY + box.top - box.height);
+    *maxY = std::max(*maxY, glyphBaseY + box.top);
 
     if (!isCombining) {
-      lastBaseLeft = glyph->left;
-      lastBaseWidth = glyph->width;
-      lastBaseTop = glyph->top;
-      prevAdvanceFP = glyph->advanceX; // 12.4 fixed-point
+      lastBaseLeft = box.left;
+      lastBaseWidth = box.width;
+      lastBaseTop = box.top;
+      prevAdvanceFP =
+          font->getAdvance(glyph, resolved.index); // 12.4 fixed-point
       prevCp = cp;
     }
   }
@@ -112,17 +131,56 @@ static uint8_t lookupKernClass(const EpdKernClassEntry *entries,
   return 0;
 }
 
+const uint8_t *EpdFont::getDirectKernClasses() const {
+  uint8_t *table = directKernClasses.load(std::memory_order_acquire);
+  if (table) {
+    return table;
+  }
+
+  table = static_cast<uint8_t *>(calloc(2 * DIRECT_KERN_COUNT, 1));
+  if (!table) {
+    return nullptr; // getKerning() falls back to the binary search
+  }
+  // Class maps are sorted by codepoint, so the common range is a prefix
+  const auto fill = [](uint8_t *out, const EpdKernClassEntry *entries,
+                       uint16_t count) {
+    for (uint16_t i = 0; i < count && entries[i].codepoint < DIRECT_KERN_COUNT;
+         i++) {
+      out[entries[i].codepoint] = entries[i].classId;
+    }
+  };
+  fill(table, data->kernLeftClasses, data->kernLeftEntryCount);
+  fill(table + DIRECT_KERN_COUNT, data->kernRightClasses,
+       data->kernRightEntryCount);
+
+  // Another task may have built the table concurrently; keep whichever won
+  uint8_t *expected = nullptr;
+  if (!directKernClasses.compare_exchange_strong(expected, table,
+                                                 std::memory_order_acq_rel)) {
+    free(table);
+    return expected;
+  }
+  return table;
+}
+
 int8_t EpdFont::getKerning(const uint32_t leftCp,
                            const uint32_t rightCp) const {
   if (!data->kernMatrix) {
     return 0;
   }
+  const uint8_t *direct = directKerning ? getDirectKernClasses() : nullptr;
   const uint8_t lc =
-      lookupKernClass(data->kernLeftClasses, data->kernLeftEntryCount, leftCp);
+      direct && leftCp < DIRECT_KERN_COUNT
+          ? direct[leftCp]
+          : lookupKernClass(data->kernLeftClasses, data->kernLeftEntryCount,
+                            leftCp);
   if (lc == 0)
     return 0;
-  const uint8_t rc = lookupKernClass(data->kernRightClasses,
-                                     data->kernRightEntryCount, rightCp);
+  const uint8_t rc =
+      direct && rightCp < DIRECT_KERN_COUNT
+          ? direct[DIRECT_KERN_COUNT + rightCp]
+          : lookupKernClass(data->kernRightClasses, data->kernRightEntryCount,
+                            rightCp);
   if (rc == 0)
     return 0;
   return data->kernMatrix[(lc - 1) * data->kernRightClassCount + (rc - 1)];
@@ -173,42 +231,146 @@ uint32_t EpdFont::applyLigatures(uint32_t cp, const char *&text) const {
   return cp;
 }
 
-const EpdGlyph *EpdFont::getGlyph(const uint32_t cp) const {
-  const int count = data->intervalCount;
-  if (count == 0 && !data->glyphMissHandler)
-    return nullptr;
-
-  if (count > 0) {
-    const EpdUnicodeInterval *intervals = data->intervals;
-    const auto *end = intervals + count;
-
-    // upper_bound: range lookup. Finds the first interval with first > cp, so
-    // the interval just before it is the last one with first <= cp. That's the
-    // only candidate that could contain cp. Then we verify cp <=
-    // candidate.last.
-    const auto it = std::upper_bound(
-        intervals, end, cp,
-        [](uint32_t value, const EpdUnicodeInterval &interval) {
-          return value < interval.first;
-        });
-
-    if (it != intervals) {
-      const auto &interval = *(it - 1);
-      if (cp <= interval.last) {
-        return &data->glyph[interval.offset + (cp - interval.first)];
-      }
+int32_t EpdFont::getGlyphIndex(const EpdGlyph *glyph) const {
+  // Glyphs loaded by glyphMissHandler live outside the font's own table
+  if (data->intervalCount == 0 || glyph < data->glyph) {
+    return -1;
+  }
+  const EpdUnicodeInterval &last = data->intervals[data->intervalCount - 1];
+  const uint32_t glyphCount = last.offset + (last.last - last.first + 1);
+  const auto index = static_cast<uint32_t>(glyph - data->glyph);
+  return index < glyphCount ? static_cast<int32_t>(index) : -1;
+}
+
+uint16_t EpdFont::getAdvance(const EpdGlyph *glyph) const {
+  return getAdvance(glyph, data->advances ? getGlyphIndex(glyph) : -1);
+}
+
+uint16_t EpdFont::getAdvance(const EpdGlyph *glyph,
+                             const int32_t index) const {
+  if (data->advances && index >= 0) {
+    return data->advances[index];
+  }
+  return glyph->advanceX;
+}
+
+EpdGlyphBounds EpdFont::getBounds(const EpdGlyph *glyph) const {
+  return getBounds(glyph, data->bounds ? getGlyphIndex(glyph) : -1);
+}
+
+EpdGlyphBounds EpdFont::getBounds(const EpdGlyph *glyph,
+                                  const int32_t index) const {
+  if (data->bounds && index >= 0) {
+    return data->bounds[index];
+  }
+  return {glyph->left, glyph->top, glyph->width, glyph->height};
+}
+
+const uint16_t *EpdFont::getDirectGlyphs() const {
+  uint16_t *table = directGlyphs.load(std::memory_order_acquire);
+  if (table) {
+    return table;
+  }
+
+  table = static_cast<uint16_t *>(
+      malloc(DIRECT_GLYPH_COUNT * sizeof(uint16_t)));
+  if (!table) {
+    return nullptr; // getGlyph() falls back to the binary search
+  }
+  std::fill(table, table + DIRECT_GLYPH_COUNT, NO_DIRECT_GLYPH);
+  for (uint32_t i = 0; i < data->intervalCount; i++) {
+    const EpdUnicodeInterval &interval = data->intervals[i];
+    if (interval.first >= DIRECT_GLYPH_COUNT) {
+      break;
+    }
+    const uint32_t last = std::min(interval.last, DIRECT_GLYPH_COUNT - 1);
+    for (uint32_t cp = interval.first; cp <= last; cp++) {
+      const uint32_t index = interval.offset + (cp - interval.first);
+      table[cp] = index < FAR_DIRECT_GLYPH ? static_cast<uint16_t>(index)
+                                           : FAR_DIRECT_GLYPH;
     }
   }
 
-  // Codepoint not in interval table — try on-demand loading (SD card fonts).
-  if (data->glyphMissHandler) {
-    const EpdGlyph *loaded = data->glyphMissHandler(data->glyphMissCtx, cp);
-    if (loaded)
-      return loaded;
+  // Another task may have built the table concurrently; keep whichever won
+  uint16_t *expected = nullptr;
+  if (!directGlyphs.compare_exchange_strong(expected, table,
+                                            std::memory_order_acq_rel)) {
+    free(table);
+    return expected;
   }
+  return table;
+}
 
+const EpdGlyph *EpdFont::getGlyph(const uint32_t cp) const {
+  if (const EpdGlyph *glyph = findGlyph(cp)) {
+    return glyph;
+  }
   if (cp != REPLACEMENT_GLYPH) {
-    return getGlyph(REPLACEMENT_GLYPH);
+    return findGlyph(REPLACEMENT_GLYPH);
+  }
+  return nullptr;
+}
+
+const EpdGlyph *EpdFont::getGlyph(const uint32_t cp, int32_t *index) const {
+  *index = findGlyphIndex(cp);
+  if (*index >= 0) {
+    return &data->glyph[*index];
+  }
+  // Loaded by glyphMissHandler, or the replacement glyph
+  const EpdGlyph *glyph = getGlyph(cp);
+  *index = glyph ? getGlyphIndex(glyph) : -1;
+  return glyph;
+}
+
+const EpdGlyph *EpdFont::findGlyph(const uint32_t cp) const {
+  const int32_t index = findGlyphIndex(cp);
+  if (index >= 0) {
+    return &data->glyph[index];
+  }
+
+  // Codepoint not in interval table — try on-demand loading (SD card fonts).
+  if (data->glyphMissHandler) {
+    return data->glyphMissHandler(data->glyphMissCtx, cp);
   }
   return nullptr;
 }
+
+int32_t EpdFont::findGlyphIndex(const uint32_t cp) const {
+  if (cp < DIRECT_GLYPH_COUNT) {
+    const uint16_t *table = getDirectGlyphs();
+    if (table) {
+      const uint16_t index = table[cp];
+      if (index == NO_DIRECT_GLYPH) {
+        return -1;
+      }
+      if (index != FAR_DIRECT_GLYPH) {
+        return index;
+      }
+    }
+  }
+
+  const int count = data->intervalCount;
+  if (count == 0) {
+    return -1;
+  }
+
+  const EpdUnicodeInterval *intervals = data->intervals;
+  const auto *end = intervals + count;
+
+  // upper_bound: range lookup. Finds the first interval with first > cp, so
+  // the interval just before it is the last one with first <= cp. That's the
+  // only candidate that could contain cp. Then we verify cp <= candidate.last.
+  const auto it = std::upper_bound(
+      intervals, end, cp,
+      [](uint32_t value, const EpdUnicodeInterval &interval) {
+        return value < interval.first;
+      });
+
+  if (it != intervals) {
+    const auto &interval = *(it - 1);
+    if (cp <= interval.last) {
+      return static_cast<int32_t>(interval.offset + (cp - interval.first));
+    }
+  }
+  return -1;
+}
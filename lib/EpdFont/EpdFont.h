@@ -1,22 +1,85 @@
 #pragma once
 #include "EpdFontData.h"
 
+#include <atomic>
+
+class EpdFontFamily;
+
 class EpdFont {
+  friend class EpdFontFamily;
+
+  /// Glyphs come from this font alone, or through the fallback chain of
+  /// family (of which this is the style font) when one is given.
   void getTextBounds(const char *string, int startX, int startY, int *minX,
-                     int *minY, int *maxX, int *maxY) const;
+                     int *minY, int *maxX, int *maxY,
+                     const EpdFontFamily *family = nullptr,
+                     uint8_t style = 0) const;
+
+  /// Glyph indices of codepoints below DIRECT_GLYPH_COUNT, built on first
+  /// use. NO_DIRECT_GLYPH marks codepoints the interval table lacks;
+  /// FAR_DIRECT_GLYPH marks glyphs whose index does not fit in 16 bits, which
+  /// are still found by binary search.
+  static constexpr uint32_t DIRECT_GLYPH_COUNT = 0x100;
+  static constexpr uint16_t NO_DIRECT_GLYPH = 0xFFFF;
+  static constexpr uint16_t FAR_DIRECT_GLYPH = 0xFFFE;
+  mutable std::atomic<uint16_t *> directGlyphs{nullptr};
+
+  /// Left then right kerning classes of codepoints below DIRECT_KERN_COUNT
+  /// (ASCII through Latin Extended-A), built on first use for fonts with
+  /// kerning.
+  static constexpr uint32_t DIRECT_KERN_COUNT = 0x180;
+  mutable std::atomic<uint8_t *> directKernClasses{nullptr};
+  bool directKerning = true;
+
+  const uint16_t *getDirectGlyphs() const;
+  const uint8_t *getDirectKernClasses() const;
 
 public:
   const EpdFontData *data;
   explicit EpdFont(const EpdFontData *data) : data(data) {}
-  ~EpdFont() = default;
+  ~EpdFont();
+  EpdFont(const EpdFont &) = delete;
+  EpdFont &operator=(const EpdFont &) = delete;
   void getTextDimensions(const char *string, int *w, int *h) const;
 
+  /// ASCII and Latin-1 codepoints are a direct table lookup; everything else
+  /// is a binary search over the unicode intervals.
   const EpdGlyph *getGlyph(uint32_t cp) const;
 
+  /// getGlyph() that also returns the glyph's index in data->glyph, or -1
+  /// for glyphs outside the table.
+  const EpdGlyph *getGlyph(uint32_t cp, int32_t *index) const;
+
+  /// Like getGlyph(), but returns nullptr instead of the replacement glyph
+  /// when the font lacks cp.
+  const EpdGlyph *findGlyph(uint32_t cp) const;
+
+  /// Index of cp's glyph in data->glyph, or -1 when the interval table lacks
+  /// it. Neither touches the glyph record nor calls glyphMissHandler.
+  int32_t findGlyphIndex(uint32_t cp) const;
+
+  /// Index of a glyph returned by getGlyph() in data->glyph, or -1 for
+  /// glyphs loaded by glyphMissHandler, which live outside the table.
+  int32_t getGlyphIndex(const EpdGlyph *glyph) const;
+
+  /// Layout metrics of a glyph returned by getGlyph(), read from the packed
+  /// metric arrays when the font has them. Pass the glyph's index when it is
+  /// already known, so the EpdGlyph record is not read at all.
+  uint16_t getAdvance(const EpdGlyph *glyph) const;
+  uint16_t getAdvance(const EpdGlyph *glyph, int32_t index) const;
+  EpdGlyphBounds getBounds(const EpdGlyph *glyph) const;
+  EpdGlyphBounds getBounds(const EpdGlyph *glyph, int32_t index) const;
+
   /// Returns the kerning adjustment (4.4 fixed-point in pixels) between two
-  /// codepoints. Returns 0 if no kerning data exists for the pair.
+  /// codepoints. Returns 0 if no kerning data exists for the pair. Pairs of
+  /// common codepoints cost two table loads and a matrix index.
   int8_t getKerning(uint32_t leftCp, uint32_t rightCp) const;
 
+  /// Keeps getKerning() on the binary search over the class maps, as when
+  /// the direct class tables cannot be allocated. Lets a benchmark time both
+  /// lookups on the same font data.
+  void setDirectKerning(bool enabled) { directKerning = enabled; }
+
   /// Returns the ligature codepoint for a pair, or 0 if no ligature exists.
   uint32_t getLigature(uint32_t leftCp, uint32_t rightCp) const;
 
@@ -99,6 +99,15 @@ typedef struct {
   uint32_t firstGlyphIndex;  ///< First glyph index in the global glyph array
 } EpdFontGroup;
 
+/// Ink box of a glyph, the layout fields of EpdGlyph without the bitmap
+/// metadata, for measurement loops
+typedef struct {
+  int16_t left;   ///< X dist from cursor pos to UL corner
+  int16_t top;    ///< Y dist from cursor pos to UL corner
+  uint8_t width;  ///< Bitmap dimensions in pixels
+  uint8_t height; ///< Bitmap dimensions in pixels
+} __attribute__((packed)) EpdGlyphBounds;
+
 /// Glyph interval structure
 typedef struct {
   uint32_t first;  ///< The first unicode code point of the interval
@@ -165,4 +174,11 @@ typedef struct {
   /// by GfxRenderer::getGlyphBitmap() to retrieve overflow bitmaps via
   /// SdCardFont.
   void *glyphMissCtx;
+
+  /// Packed copies of the layout metrics, indexed like `glyph`, so measuring
+  /// text does not pull whole 16-byte EpdGlyph records through the cache.
+  /// Both are nullptr in fonts converted without them; new fields go last
+  /// because font headers initialize this struct positionally.
+  const uint16_t *advances; ///< Per-glyph advanceX, 12.4 fixed-point
+  const EpdGlyphBounds *bounds; ///< Per-glyph ink box (optional)
 } EpdFontData;
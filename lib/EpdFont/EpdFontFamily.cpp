@@ -1,5 +1,28 @@
 #include "EpdFontFamily.h"
 
+#include <Utf8.h>
+
+#include <initializer_list>
+#include <new>
+
+namespace {
+// Resolve cache entry layout: codepoint (21 bits), style (2 bits) and font
+// slot + 1 (3 bits, 0 marks an empty entry) in the key, glyph index above it
+constexpr uint32_t CACHE_STYLE_SHIFT = 21;
+constexpr uint32_t CACHE_SLOT_SHIFT = 23;
+constexpr uint32_t CACHE_INDEX_SHIFT = 32;
+constexpr uint64_t CACHE_KEY_MASK = (1ULL << 26) - 1;
+// Glyph index of glyphs outside the font's table; the font is asked again
+constexpr uint32_t CACHE_NO_INDEX = 0xFFFFFFFF;
+
+uint64_t cacheKey(const uint32_t cp, const uint8_t style, const uint8_t slot) {
+  return cp | static_cast<uint64_t>(style) << CACHE_STYLE_SHIFT |
+         static_cast<uint64_t>(slot + 1) << CACHE_SLOT_SHIFT;
+}
+} // namespace
+
+EpdFontFamily::~EpdFontFamily() { delete[] resolveCache.load(); }
+
 const EpdFont *EpdFontFamily::getFont(const Style style) const {
   // Extract font style bits (ignore UNDERLINE bit for font selection)
   const bool hasBold = (style & BOLD) != 0;
@@ -23,7 +46,11 @@ const EpdFont *EpdFontFamily::getFont(const Style style) const {
 
 void EpdFontFamily::getTextDimensions(const char *string, int *w, int *h,
                                       const Style style) const {
-  getFont(style)->getTextDimensions(string, w, h);
+  int minX = 0, minY = 0, maxX = 0, maxY = 0;
+  getFont(style)->getTextBounds(string, 0, 0, &minX, &minY, &maxX, &maxY,
+                                this, style);
+  *w = maxX - minX;
+  *h = maxY - minY;
 }
 
 const EpdFontData *EpdFontFamily::getData(const Style style) const {
@@ -32,7 +59,115 @@ const EpdFontData *EpdFontFamily::getData(const Style style) const {
 
 const EpdGlyph *EpdFontFamily::getGlyph(const uint32_t cp,
                                         const Style style) const {
-  return getFont(style)->getGlyph(cp);
+  return resolveGlyph(cp, style).glyph;
+}
+
+bool EpdFontFamily::addFallback(const EpdFontFamily *family) {
+  if (!family || family == this || fallbackCount == MAX_FALLBACKS) {
+    return false;
+  }
+  fallbacks[fallbackCount++] = family;
+  resetResolveCache();
+  return true;
+}
+
+void EpdFontFamily::clearFallbacks() {
+  fallbackCount = 0;
+  resetResolveCache();
+}
+
+void EpdFontFamily::resetResolveCache() {
+  if (std::atomic<uint64_t> *cache = resolveCache.load()) {
+    for (uint32_t i = 0; i < RESOLVE_CACHE_SIZE; i++) {
+      cache[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+const EpdFont *EpdFontFamily::getChainFont(const uint8_t slot,
+                                           const Style style) const {
+  return slot == 0 ? getFont(style) : fallbacks[slot - 1]->getFont(style);
+}
+
+std::atomic<uint64_t> *EpdFontFamily::getResolveCache() const {
+  std::atomic<uint64_t> *cache = resolveCache.load(std::memory_order_acquire);
+  if (cache) {
+    return cache;
+  }
+
+  cache = new (std::nothrow) std::atomic<uint64_t>[RESOLVE_CACHE_SIZE]();
+  if (!cache) {
+    return nullptr; // resolveGlyph() walks the chain every time
+  }
+
+  // Another task may have built the cache concurrently; keep whichever won
+  std::atomic<uint64_t> *expected = nullptr;
+  if (!resolveCache.compare_exchange_strong(expected, cache,
+                                            std::memory_order_acq_rel)) {
+    delete[] cache;
+    return expected;
+  }
+  return cache;
+}
+
+EpdFontFamily::ResolvedGlyph
+EpdFontFamily::resolveGlyph(const uint32_t cp, const Style style) const {
+  const EpdFont *font = getFont(style);
+  if (fallbackCount == 0 || cp > 0x1FFFFF) {
+    ResolvedGlyph resolved;
+    resolved.font = font;
+    resolved.glyph = font->getGlyph(cp, &resolved.index);
+    return resolved;
+  }
+
+  const auto styleBits = static_cast<uint8_t>(style & BOLD_ITALIC);
+  std::atomic<uint64_t> *cache = getResolveCache();
+  std::atomic<uint64_t> *entry =
+      cache ? &cache[cp % RESOLVE_CACHE_SIZE] : nullptr;
+  if (entry) {
+    const uint64_t cached = entry->load(std::memory_order_relaxed);
+    const auto slot =
+        static_cast<uint8_t>(((cached >> CACHE_SLOT_SHIFT) & 7) - 1);
+    if (cached != 0 && slot <= fallbackCount &&
+        (cached & CACHE_KEY_MASK) == cacheKey(cp, styleBits, slot)) {
+      const EpdFont *owner = getChainFont(slot, style);
+      const auto index = static_cast<uint32_t>(cached >> CACHE_INDEX_SHIFT);
+      if (index != CACHE_NO_INDEX) {
+        return {owner, &owner->data->glyph[index],
+                static_cast<int32_t>(index)};
+      }
+      if (const EpdGlyph *glyph = owner->findGlyph(cp)) {
+        return {owner, glyph, -1};
+      }
+    }
+  }
+
+  // When no font in the chain has cp, the chain's replacement glyph is cached
+  // under cp instead, so unknown codepoints cost one lookup from then on
+  ResolvedGlyph resolved = {font, nullptr, -1};
+  uint8_t resolvedSlot = 0;
+  for (const uint32_t target : {cp, static_cast<uint32_t>(REPLACEMENT_GLYPH)}) {
+    for (uint8_t slot = 0; slot <= fallbackCount && !resolved.glyph; slot++) {
+      const EpdFont *candidate = getChainFont(slot, style);
+      if (const EpdGlyph *glyph = candidate->findGlyph(target)) {
+        resolved = {candidate, glyph, candidate->getGlyphIndex(glyph)};
+        resolvedSlot = slot;
+      }
+    }
+    if (resolved.glyph || cp == REPLACEMENT_GLYPH) {
+      break;
+    }
+  }
+
+  if (entry && resolved.glyph) {
+    const uint32_t stored = resolved.index >= 0
+                                ? static_cast<uint32_t>(resolved.index)
+                                : CACHE_NO_INDEX;
+    entry->store(cacheKey(cp, styleBits, resolvedSlot) |
+                     static_cast<uint64_t>(stored) << CACHE_INDEX_SHIFT,
+                 std::memory_order_relaxed);
+  }
+  return resolved;
 }
 
 int8_t EpdFontFamily::getKerning(const uint32_t leftCp, const uint32_t rightCp,
@@ -44,3 +179,44 @@ uint32_t EpdFontFamily::applyLigatures(const uint32_t cp, const char *&text,
                                        const Style style) const {
   return getFont(style)->applyLigatures(cp, text);
 }
+
+int EpdFontFamily::measureAdvances(const char *text, const Style style,
+                                   int32_t *prefixWidths) const {
+  const EpdFont *font = getFont(style);
+  const auto *p = reinterpret_cast<const uint8_t *>(text);
+  int baseX = 0;             // pen position of the last base glyph
+  int32_t prevAdvanceFP = 0; // 12.4 fixed-point
+  uint32_t prevCp = 0;
+  int width = 0;
+
+  prefixWidths[0] = 0;
+  while (*p) {
+    const uint8_t *start = p;
+    uint32_t cp = utf8NextCodepoint(&p);
+
+    // Combining marks sit over their base and add nothing
+    if (!utf8IsCombiningMark(cp)) {
+      const char *rest = reinterpret_cast<const char *>(p);
+      cp = font->applyLigatures(cp, rest);
+      p = reinterpret_cast<const uint8_t *>(rest);
+
+      if (prevCp != 0) {
+        baseX += fp4::toPixel(prevAdvanceFP + font->getKerning(prevCp, cp));
+      }
+      const ResolvedGlyph resolved = resolveGlyph(cp, style);
+      prevAdvanceFP =
+          resolved.glyph
+              ? resolved.font->getAdvance(resolved.glyph, resolved.index)
+              : 0;
+      prevCp = cp;
+      width = baseX + fp4::toPixel(prevAdvanceFP);
+    }
+
+    const auto *base = reinterpret_cast<const uint8_t *>(text);
+    for (const uint8_t *q = start + 1; q < p; q++) {
+      prefixWidths[q - base] = prefixWidths[start - base];
+    }
+    prefixWidths[p - base] = width;
+  }
+  return width;
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "EpdFont.h"
 
+#include <atomic>
+
 class EpdFontFamily {
 public:
   enum Style : uint8_t {
@@ -11,25 +13,77 @@ public:
     UNDERLINE = 4
   };
 
+  /// A glyph and the font its bitmap and metrics belong to, with its index in
+  /// font->data->glyph (-1 for glyphs outside the table) for metric lookups
+  struct ResolvedGlyph {
+    const EpdFont *font = nullptr;
+    const EpdGlyph *glyph = nullptr;
+    int32_t index = -1;
+  };
+
+  static constexpr uint8_t MAX_FALLBACKS = 3;
+
   explicit EpdFontFamily(const EpdFont *regular, const EpdFont *bold = nullptr,
                          const EpdFont *italic = nullptr,
                          const EpdFont *boldItalic = nullptr)
       : regular(regular), bold(bold), italic(italic), boldItalic(boldItalic) {}
-  ~EpdFontFamily() = default;
+  ~EpdFontFamily();
+  EpdFontFamily(const EpdFontFamily &) = delete;
+  EpdFontFamily &operator=(const EpdFontFamily &) = delete;
+
+  /// Appends a family to consult, in order, for codepoints this family
+  /// lacks, e.g. builtin NotoSans -> SD card CJK -> symbols. Each fallback
+  /// lends its font of the requested style; its own fallbacks are not
+  /// followed. Change the chain only while no text is being laid out with
+  /// this family. Returns false when the chain is full.
+  bool addFallback(const EpdFontFamily *family);
+  void clearFallbacks();
+
+  /// The glyph of cp from the first font of the chain that has it, else this
+  /// family's replacement glyph. With fallbacks configured, results are
+  /// remembered in a small direct-mapped cache, so repeated codepoints skip
+  /// the failed interval searches of the fonts before the one that has them.
+  ResolvedGlyph resolveGlyph(uint32_t cp, Style style = REGULAR) const;
+
   void getTextDimensions(const char *string, int *w, int *h,
                          Style style = REGULAR) const;
+  /// Data of the style's own font; glyphs resolved from a fallback use
+  /// ResolvedGlyph::font->data instead
   const EpdFontData *getData(Style style = REGULAR) const;
+  /// resolveGlyph() without the font
   const EpdGlyph *getGlyph(uint32_t cp, Style style = REGULAR) const;
   int8_t getKerning(uint32_t leftCp, uint32_t rightCp,
                     Style style = REGULAR) const;
   uint32_t applyLigatures(uint32_t cp, const char *&text,
                           Style style = REGULAR) const;
 
+  /// Advance widths of every prefix of text, in one pass that only touches
+  /// glyph advances and kerning (fp4, snapped per glyph step like drawing).
+  /// prefixWidths needs strlen(text) + 1 entries: prefixWidths[i] is the
+  /// width in pixels of the first i bytes. Bytes inside a multi-byte
+  /// character or a ligature repeat the width before it. Find line breaks or
+  /// truncation points by binary search over the result. Returns the width of
+  /// the whole text.
+  int measureAdvances(const char *text, Style style,
+                      int32_t *prefixWidths) const;
+
 private:
   const EpdFont *regular;
   const EpdFont *bold;
   const EpdFont *italic;
   const EpdFont *boldItalic;
+  const EpdFontFamily *fallbacks[MAX_FALLBACKS] = {};
+  uint8_t fallbackCount = 0;
+
+  /// Resolved codepoints, direct-mapped by codepoint. Each entry packs the
+  /// codepoint, style and font slot (0 = own font, 1.. = fallbacks) with the
+  /// glyph index in the upper half, so entries are read and written as one
+  /// atomic word. Allocated on first lookup through a fallback chain.
+  static constexpr uint32_t RESOLVE_CACHE_SIZE = 128;
+  mutable std::atomic<std::atomic<uint64_t> *> resolveCache{nullptr};
 
   const EpdFont *getFont(Style style) const;
+  const EpdFont *getChainFont(uint8_t slot, Style style) const;
+  std::atomic<uint64_t> *getResolveCache() const;
+  void resetResolveCache();
 };
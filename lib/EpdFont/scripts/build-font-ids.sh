@@ -1,137 +1,85 @@
 #!/bin/bash
+#
+# Regenerate src/os/graphic/FontIds.h:
+#   ./lib/EpdFont/scripts/build-font-ids.sh > src/os/graphic/FontIds.h
 
 set -e
 
 cd "$(dirname "$0")/../builtinFonts"
 
+# Every builtin family as its header prefix, font ID name and typeface group. Styles come from
+# whichever <prefix>_<style>.h headers exist. A build can leave a group's font data out of the
+# firmware with -DOMIT_<GROUP>_FONTS; families in the "-" group are always built in.
+FAMILIES=(
+  "notoserif_12 NOTOSERIF_12 NOTOSERIF"
+  "notoserif_14 NOTOSERIF_14 NOTOSERIF"
+  "notoserif_16 NOTOSERIF_16 NOTOSERIF"
+  "notoserif_18 NOTOSERIF_18 NOTOSERIF"
+  "notosans_12 NOTOSANS_12 -"
+  "notosans_14 NOTOSANS_14 -"
+  "notosans_16 NOTOSANS_16 -"
+  "notosans_18 NOTOSANS_18 -"
+  "opendyslexic_8 OPENDYSLEXIC_8 OPENDYSLEXIC"
+  "opendyslexic_10 OPENDYSLEXIC_10 OPENDYSLEXIC"
+  "opendyslexic_12 OPENDYSLEXIC_12 OPENDYSLEXIC"
+  "opendyslexic_14 OPENDYSLEXIC_14 OPENDYSLEXIC"
+  "ubuntu_10 UI_10 -"
+  "ubuntu_12 UI_12 -"
+  "notosans_8 SMALL -"
+)
+OPTIONAL_GROUPS=(NOTOSERIF OPENDYSLEXIC)
+
+# Font ID of a family: the sum of the SHA256 of its headers, folded into an int32
+font_id() {
+  ruby -rdigest -e 'puts ARGV.map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)' "$@"
+}
+
+# Font data symbol of one style, or nullptr when the family has no such header
+style_ref() {
+  if [ -f "./$1_$2.h" ]; then
+    echo "&$1_$2"
+  else
+    echo "nullptr"
+  fi
+}
+
+# Families of one group as X(...) lines continuing a macro definition
+group_entries() {
+  for family in "${FAMILIES[@]}"; do
+    read -r name id group <<< "$family"
+    [ "$group" = "$1" ] || continue
+    echo "  X(${id}_FONT_ID, $(style_ref "$name" regular), $(style_ref "$name" bold), $(style_ref "$name" italic), $(style_ref "$name" bolditalic)) \\"
+  done
+}
+
 echo "// The contents of this file are generated by ./lib/EpdFont/scripts/build-font-ids.sh"
 echo "#pragma once"
 echo ""
 
-echo "#define NOTOSERIF_12_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notoserif_12_regular.h",
-  "./notoserif_12_bold.h",
-  "./notoserif_12_bolditalic.h",
-  "./notoserif_12_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define NOTOSERIF_14_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notoserif_14_regular.h",
-  "./notoserif_14_bold.h",
-  "./notoserif_14_bolditalic.h",
-  "./notoserif_14_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define NOTOSERIF_16_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notoserif_16_regular.h",
-  "./notoserif_16_bold.h",
-  "./notoserif_16_bolditalic.h",
-  "./notoserif_16_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define NOTOSERIF_18_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notoserif_18_regular.h",
-  "./notoserif_18_bold.h",
-  "./notoserif_18_bolditalic.h",
-  "./notoserif_18_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define NOTOSANS_12_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notosans_12_regular.h",
-  "./notosans_12_bold.h",
-  "./notosans_12_bolditalic.h",
-  "./notosans_12_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define NOTOSANS_14_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notosans_14_regular.h",
-  "./notosans_14_bold.h",
-  "./notosans_14_bolditalic.h",
-  "./notosans_14_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define NOTOSANS_16_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notosans_16_regular.h",
-  "./notosans_16_bold.h",
-  "./notosans_16_bolditalic.h",
-  "./notosans_16_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define NOTOSANS_18_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notosans_18_regular.h",
-  "./notosans_18_bold.h",
-  "./notosans_18_bolditalic.h",
-  "./notosans_18_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
+for family in "${FAMILIES[@]}"; do
+  read -r name id group <<< "$family"
+  headers=()
+  for style in regular bold bolditalic italic; do
+    [ -f "./${name}_${style}.h" ] && headers+=("./${name}_${style}.h")
+  done
+  echo "#define ${id}_FONT_ID ($(font_id "${headers[@]}"))"
+done
 
-echo "#define OPENDYSLEXIC_8_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./opendyslexic_8_regular.h",
-  "./opendyslexic_8_bold.h",
-  "./opendyslexic_8_bolditalic.h",
-  "./opendyslexic_8_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define OPENDYSLEXIC_10_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./opendyslexic_10_regular.h",
-  "./opendyslexic_10_bold.h",
-  "./opendyslexic_10_bolditalic.h",
-  "./opendyslexic_10_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define OPENDYSLEXIC_12_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./opendyslexic_12_regular.h",
-  "./opendyslexic_12_bold.h",
-  "./opendyslexic_12_bolditalic.h",
-  "./opendyslexic_12_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define OPENDYSLEXIC_14_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./opendyslexic_14_regular.h",
-  "./opendyslexic_14_bold.h",
-  "./opendyslexic_14_bolditalic.h",
-  "./opendyslexic_14_italic.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define UI_10_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./ubuntu_10_regular.h",
-  "./ubuntu_10_bold.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define UI_12_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./ubuntu_12_regular.h",
-  "./ubuntu_12_bold.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
-
-echo "#define SMALL_FONT_ID ($(
-ruby -rdigest -e 'puts [
-  "./notosans_8_regular.h",
-].map{|f| Digest::SHA256.hexdigest(File.read(f)).to_i(16) }.sum % (2 ** 32) - (2 ** 31)'
-))"
+echo ""
+echo "// Builtin families as X(id, regular, bold, italic, boldItalic), styles a family lacks being nullptr."
+echo "// IDs of omitted groups stay defined but are not found by findFontFamilyById()."
+for group in "${OPTIONAL_GROUPS[@]}"; do
+  echo "#ifdef OMIT_${group}_FONTS"
+  echo "#define BUILTIN_${group}_FONT_FAMILIES(X)"
+  echo "#else"
+  echo "#define BUILTIN_${group}_FONT_FAMILIES(X) \\"
+  group_entries "$group"
+  echo ""
+  echo "#endif"
+done
+echo "#define BUILTIN_FONT_FAMILIES(X) \\"
+group_entries "-"
+for group in "${OPTIONAL_GROUPS[@]}"; do
+  echo "  BUILTIN_${group}_FONT_FAMILIES(X) \\"
+done
+echo ""
@@ -1,7 +1,34 @@
 #!/bin/bash
+#
+# Regenerate the builtin font headers, then src/os/graphic/FontIds.h.
+#
+# A deployment that knows the text it shows can subset every builtin font to it:
+#   ./convert-builtin-fonts.sh --corpus books.txt --corpus ui-strings.txt
+#   ./convert-builtin-fonts.sh --whitelist codepoints.txt
+# Code points left out of a subset render as the replacement glyph. EpdFontFamily::addFallback()
+# can chain a fuller family to draw them, but nothing registers an SD card fallback yet. The
+# flash saved is reported per family, relative to the headers being replaced.
 
 set -e
 
+SUBSET_ARGS=()
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --whitelist)
+      SUBSET_ARGS+=(--subset-whitelist "$(realpath "$2")")
+      shift 2
+      ;;
+    --corpus)
+      SUBSET_ARGS+=(--subset-corpus "$(realpath "$2")")
+      shift 2
+      ;;
+    *)
+      echo "Usage: $0 [--whitelist FILE]... [--corpus FILE]..." >&2
+      exit 1
+      ;;
+  esac
+done
+
 cd "$(dirname "$0")"
 
 READER_FONT_STYLES=("Regular" "Italic" "Bold" "BoldItalic")
@@ -9,51 +36,88 @@ NOTOSERIF_FONT_SIZES=(12 14 16 18)
 NOTOSANS_FONT_SIZES=(12 14 16 18)
 OPENDYSLEXIC_FONT_SIZES=(8 10 12 14)
 
+REPORT=()
+
+# Flash footprint of a family's headers, in bytes
+family_size() {
+  python font_flash_size.py --total ../builtinFonts/$1_*.h
+}
+
+# Record the flash a family saved; takes the family name and its size before conversion
+report_family() {
+  local after
+  after=$(family_size "$1")
+  REPORT+=("$(printf '%-16s %8d -> %8d bytes, saved %5d KiB' "$1" "$2" "$after" $((($2 - after) / 1024)))")
+}
+
 for size in ${NOTOSERIF_FONT_SIZES[@]}; do
+  before=$(family_size "notoserif_${size}")
   for style in ${READER_FONT_STYLES[@]}; do
     font_name="notoserif_${size}_$(echo $style | tr '[:upper:]' '[:lower:]')"
     font_path="../builtinFonts/source/NotoSerif/NotoSerif-${style}.ttf"
     output_path="../builtinFonts/${font_name}.h"
-    python fontconvert.py $font_name $size $font_path --2bit --compress --pnum > $output_path
+    python fontconvert.py $font_name $size $font_path --2bit --compress --pnum --bounds "${SUBSET_ARGS[@]}" > $output_path
     echo "Generated $output_path"
   done
+  report_family "notoserif_${size}" $before
 done
 
 for size in ${NOTOSANS_FONT_SIZES[@]}; do
+  before=$(family_size "notosans_${size}")
   for style in ${READER_FONT_STYLES[@]}; do
     font_name="notosans_${size}_$(echo $style | tr '[:upper:]' '[:lower:]')"
     font_path="../builtinFonts/source/NotoSans/NotoSans-${style}.ttf"
     output_path="../builtinFonts/${font_name}.h"
-    python fontconvert.py $font_name $size $font_path --2bit --compress --pnum > $output_path
+    python fontconvert.py $font_name $size $font_path --2bit --compress --pnum --bounds "${SUBSET_ARGS[@]}" > $output_path
     echo "Generated $output_path"
   done
+  report_family "notosans_${size}" $before
 done
 
 for size in ${OPENDYSLEXIC_FONT_SIZES[@]}; do
+  before=$(family_size "opendyslexic_${size}")
   for style in ${READER_FONT_STYLES[@]}; do
     font_name="opendyslexic_${size}_$(echo $style | tr '[:upper:]' '[:lower:]')"
     font_path="../builtinFonts/source/OpenDyslexic/OpenDyslexic-${style}.otf"
     output_path="../builtinFonts/${font_name}.h"
-    python fontconvert.py $font_name $size $font_path --2bit --compress > $output_path
+    python fontconvert.py $font_name $size $font_path --2bit --compress --bounds "${SUBSET_ARGS[@]}" > $output_path
     echo "Generated $output_path"
   done
+  report_family "opendyslexic_${size}" $before
 done
 
 UI_FONT_SIZES=(10 12)
 UI_FONT_STYLES=("Regular" "Bold")
 
 for size in ${UI_FONT_SIZES[@]}; do
+  before=$(family_size "ubuntu_${size}")
   for style in ${UI_FONT_STYLES[@]}; do
     font_name="ubuntu_${size}_$(echo $style | tr '[:upper:]' '[:lower:]')"
     font_path="../builtinFonts/source/Ubuntu/Ubuntu-${style}.ttf"
     output_path="../builtinFonts/${font_name}.h"
-    python fontconvert.py $font_name $size $font_path > $output_path
+    python fontconvert.py $font_name $size $font_path --bounds "${SUBSET_ARGS[@]}" > $output_path
     echo "Generated $output_path"
   done
+  report_family "ubuntu_${size}" $before
 done
 
-python fontconvert.py notosans_8_regular 8 ../builtinFonts/source/NotoSans/NotoSans-Regular.ttf > ../builtinFonts/notosans_8_regular.h
+before=$(family_size "notosans_8")
+python fontconvert.py notosans_8_regular 8 ../builtinFonts/source/NotoSans/NotoSans-Regular.ttf --bounds "${SUBSET_ARGS[@]}" > ../builtinFonts/notosans_8_regular.h
+report_family "notosans_8" $before
 
 echo ""
 echo "Running compression verification..."
 python verify_compression.py ../builtinFonts/
+
+# Font IDs hash the header contents, so they change with every regeneration
+./build-font-ids.sh > ../../../src/os/graphic/FontIds.h
+echo "Generated src/os/graphic/FontIds.h"
+
+echo ""
+echo "Flash per family:"
+printf '  %s\n' "${REPORT[@]}"
+if [ ${#SUBSET_ARGS[@]} -gt 0 ]; then
+  echo ""
+  echo "Fonts are subsetted: code points outside the subset render as the replacement glyph"
+  echo "unless a fallback family is registered with EpdFontFamily::addFallback()."
+fi
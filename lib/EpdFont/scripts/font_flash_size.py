@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Flash footprint of generated font headers.
+
+Sums the sizes of the const data arrays a fontconvert.py header defines
+(bitmaps, glyphs, intervals, groups, kerning, ligatures and the packed
+metric arrays), using the struct sizes of EpdFontData.h on the ESP32. The
+EpdFontData record itself is the same for every font and not counted.
+
+Usage:
+    # One total per header
+    python font_flash_size.py ../builtinFonts/notosans_12_*.h
+
+    # Total of all headers only
+    python font_flash_size.py --total ../builtinFonts/notosans_12_*.h
+"""
+import argparse
+import re
+import sys
+
+# sizeof() of every array element type fontconvert.py emits
+ELEMENT_SIZES = {
+    'uint8_t': 1,
+    'int8_t': 1,
+    'uint16_t': 2,
+    'EpdGlyph': 16,
+    'EpdUnicodeInterval': 12,
+    'EpdFontGroup': 20,
+    'EpdKernClassEntry': 3,
+    'EpdLigaturePair': 8,
+    'EpdGlyphBounds': 6,
+}
+
+ARRAY_RE = re.compile(r'static const (\w+) \w+\[(\d*)\] = \{(.*?)\};', re.S)
+
+
+def count_elements(type_name, body):
+    """Number of elements in an array initializer, comments stripped"""
+    body = re.sub(r'//[^\n]*', '', body)
+    if type_name in ('uint8_t', 'int8_t', 'uint16_t'):
+        return len(re.findall(r'-?\b(?:0x[0-9A-Fa-f]+|\d+)\b', body))
+    return body.count('{')
+
+
+def header_flash_size(path):
+    """Bytes of const array data defined by one font header"""
+    with open(path, 'r', encoding='utf-8') as f:
+        text = f.read()
+    total = 0
+    for type_name, declared, body in ARRAY_RE.findall(text):
+        if type_name not in ELEMENT_SIZES:
+            print(f"{path}: unknown array type {type_name}, not counted", file=sys.stderr)
+            continue
+        count = int(declared) if declared else count_elements(type_name, body)
+        total += count * ELEMENT_SIZES[type_name]
+    return total
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report the flash footprint of generated font headers.")
+    parser.add_argument("headers", nargs='+', help="fontconvert.py output headers")
+    parser.add_argument("--total", action="store_true", help="print only the sum over all headers, in bytes")
+    args = parser.parse_args()
+
+    total = 0
+    for path in args.headers:
+        size = header_flash_size(path)
+        total += size
+        if not args.total:
+            print(f"{path}: {size} bytes")
+    print(total if args.total else f"total: {total} bytes")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,86 @@
+"""
+Corpus / whitelist subsetting for fontconvert.py.
+
+A deployment that knows what text it shows keeps only those code points of
+the exported intervals. Everything else renders as the replacement glyph,
+unless a fuller family is chained with EpdFontFamily::addFallback (no SD
+fallback is registered yet). Printable ASCII, the Latin ligatures and the
+replacement character always stay, so layout, ligature substitution and
+missing-glyph rendering keep working.
+
+Kept apart from fontconvert.py so it can be imported (and tested) without
+freetype.
+
+Whitelist format, one or more tokens per line separated by spaces or commas:
+    U+00E9          a code point (also u+00e9, 0xE9 or a decimal number)
+    U+0400-U+04FF   an inclusive range
+    # comment       everything after # is ignored
+"""
+
+SUBSET_ALWAYS_KEEP = [(0x0020, 0x007E), (0xFB00, 0xFB06), (0xFFFD, 0xFFFD)]
+
+MAX_CODE_POINT = 0x10FFFF
+
+
+def parse_code_point(token):
+    """Code point of one whitelist token; ValueError if it is not one."""
+    if token[:2].upper() == "U+":
+        cp = int(token[2:], 16)
+    else:
+        cp = int(token, 0)
+    if not 0 <= cp <= MAX_CODE_POINT:
+        raise ValueError(f"code point out of range: {token}")
+    return cp
+
+
+def parse_subset_whitelist(lines, source="<whitelist>"):
+    """Set of code points listed in the lines of a whitelist."""
+    keep = set()
+    for number, line in enumerate(lines, 1):
+        for token in line.split("#", 1)[0].replace(",", " ").split():
+            first, dash, last = token.partition("-")
+            try:
+                first = parse_code_point(first)
+                last = parse_code_point(last) if dash else first
+            except ValueError as e:
+                raise ValueError(f"{source}:{number}: bad code point token '{token}'") from e
+            if last < first:
+                raise ValueError(f"{source}:{number}: reversed range '{token}'")
+            keep.update(range(first, last + 1))
+    return keep
+
+
+def read_subset_whitelist(path):
+    with open(path, encoding="utf-8") as f:
+        return parse_subset_whitelist(f, path)
+
+
+def read_subset_corpus(path):
+    """Set of code points of the characters of a UTF-8 text file."""
+    with open(path, encoding="utf-8", errors="replace") as f:
+        return set(ord(c) for c in f.read())
+
+
+def subset_keep(whitelists, corpora):
+    """Code points to keep for the given whitelist and corpus files."""
+    keep = set()
+    for start, end in SUBSET_ALWAYS_KEEP:
+        keep.update(range(start, end + 1))
+    for path in whitelists:
+        keep |= read_subset_whitelist(path)
+    for path in corpora:
+        keep |= read_subset_corpus(path)
+    return keep
+
+
+def subset_intervals(ranges, keep):
+    """Code points of keep inside ranges, as sorted inclusive intervals."""
+    subset = []
+    for cp in sorted(keep):
+        if not any(start <= cp <= end for start, end in ranges):
+            continue
+        if subset and subset[-1][1] == cp - 1:
+            subset[-1] = (subset[-1][0], cp)
+        else:
+            subset.append((cp, cp))
+    return subset
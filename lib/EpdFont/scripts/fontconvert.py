@@ -6,6 +6,8 @@ import math
 import argparse
 from collections import namedtuple
 
+from font_subset import subset_intervals, subset_keep
+
 # Force UTF-8 stdout so that `python fontconvert.py … > foo.h` on Windows
 # (default cp1252) doesn't emit UTF-16 LE / replacement chars in the generated
 # header. Wrapped in a hasattr guard so it's a no-op on older Pythons.
@@ -20,6 +22,9 @@ parser.add_argument("size", type=int, help="font size to use.")
 parser.add_argument("fontstack", action="store", nargs='+', help="list of font files, ordered by descending priority.")
 parser.add_argument("--2bit", dest="is2Bit", action="store_true", help="generate 2-bit greyscale bitmap instead of 1-bit black and white.")
 parser.add_argument("--additional-intervals", dest="additional_intervals", action="append", help="Additional code point intervals to export as min,max. This argument can be repeated.")
+parser.add_argument("--bounds", dest="bounds", action="store_true", help="Also emit a packed per-glyph ink box array, so text measurement never reads the EpdGlyph table.")
+parser.add_argument("--subset-whitelist", dest="subset_whitelist", action="append", help="File of code points to keep (U+XXXX or 0xXX, ranges as first-last, # comments). Restricts the exported intervals to them. This argument can be repeated.")
+parser.add_argument("--subset-corpus", dest="subset_corpus", action="append", help="UTF-8 text file whose characters to keep. Restricts the exported intervals to them. This argument can be repeated.")
 parser.add_argument("--compress", dest="compress", action="store_true", help="Compress glyph bitmaps using DEFLATE with group-based compression.")
 parser.add_argument("--force-autohint", dest="force_autohint", action="store_true", help="Force FreeType auto-hinter instead of native font hinting. Improves stem width consistency for fonts with weak or no native TrueType hints.")
 parser.add_argument("--pnum", dest="pnum", action="store_true", help="Use proportional numerals (pnum OpenType feature) instead of default tabular figures. Reduces visual gaps between digits in running prose.")
@@ -139,6 +144,15 @@ add_ints = []
 if args.additional_intervals:
     add_ints = [tuple([int(n, base=0) for n in i.split(",")]) for i in args.additional_intervals]
 
+# --- Corpus / whitelist subsetting, see font_subset.py ---
+if args.subset_whitelist or args.subset_corpus:
+    keep = subset_keep(args.subset_whitelist or [], args.subset_corpus or [])
+    full_count = len(set(cp for start, end in intervals + add_ints for cp in range(start, end + 1)))
+    intervals = subset_intervals(intervals + add_ints, keep)
+    add_ints = []
+    kept_count = sum(end - start + 1 for start, end in intervals)
+    print(f"subset: keeping {kept_count} of {full_count} code points in {len(intervals)} intervals", file=sys.stderr)
+
 def norm_floor(val):
     return int(math.floor(val / (1 << 6)))
 
@@ -947,6 +961,19 @@ for i, g in enumerate(glyph_props):
     print ("    { " + ", ".join([f"{a}" for a in list(g[:-1])]),"},", f"// {cp_label(g.code_point)}")
 print ("};\n");
 
+# Packed layout metrics, indexed like the glyph table. Measurement walks
+# these instead of the 16-byte EpdGlyph records.
+print(f"static const uint16_t {font_name}Advances[] = {{")
+for i in range(0, len(glyph_props), 12):
+    print("    " + ", ".join(f"{g.advance_x}" for g in glyph_props[i:i + 12]) + ",")
+print("};\n")
+
+if args.bounds:
+    print(f"static const EpdGlyphBounds {font_name}Bounds[] = {{")
+    for g in glyph_props:
+        print(f"    {{ {g.left}, {g.top}, {g.width}, {g.height} }}, // {cp_label(g.code_point)}")
+    print("};\n")
+
 print(f"static const EpdUnicodeInterval {font_name}Intervals[] = {{")
 offset = 0
 for i_start, i_end in intervals:
@@ -1025,4 +1052,9 @@ if ligature_pairs:
 else:
     print(f"    nullptr,")
     print(f"    0,")
+# glyphMissHandler, glyphMissCtx (set at runtime for SD card fonts)
+print("    nullptr,")
+print("    nullptr,")
+print(f"    {font_name}Advances,")
+print(f"    {font_name}Bounds," if args.bounds else "    nullptr,")
 print("};")
@@ -712,10 +712,21 @@ def rasterize_font_style(fontfile, size, intervals, style_id=0, force_autohint=F
 GLYPH_STRUCT_FORMAT = "<BBHhhH2xI"
 assert struct.calcsize(GLYPH_STRUCT_FORMAT) == 16
 
+# EpdGlyphBounds struct: 6 bytes, little-endian
+BOUNDS_STRUCT_FORMAT = "<hhBB"
+assert struct.calcsize(BOUNDS_STRUCT_FORMAT) == 6
 
-def pack_style_sections(sd):
+# Header flags
+FLAG_2BIT = 1
+FLAG_ADVANCES = 2  # packed uint16 advance per glyph follows each style's bitmaps
+FLAG_BOUNDS = 4    # packed EpdGlyphBounds per glyph follows the advances
+
+
+def pack_style_sections(sd, bounds=False):
     """Pack one StyleRasterData into binary section bytearrays.
-    Returns (intervals_data, glyphs_data, kern_left, kern_right, kern_matrix, ligatures, bitmaps)."""
+    Returns (intervals_data, glyphs_data, kern_left, kern_right, kern_matrix, ligatures, bitmaps,
+    advances, bounds). The metric sections come last so readers that locate sections from the
+    TOC counts alone still find everything before them; bounds is empty unless requested."""
     intervals_data = bytearray()
     offset = 0
     for i_start, i_end in sd.intervals:
@@ -750,8 +761,18 @@ def pack_style_sections(sd):
         bitmap_data += packed
     assert len(bitmap_data) == sd.total_bitmap_size
 
+    advances_data = bytearray()
+    for glyph, packed in sd.all_glyphs:
+        advances_data += struct.pack("<H", glyph.advance_x)
+
+    bounds_data = bytearray()
+    if bounds:
+        for glyph, packed in sd.all_glyphs:
+            bounds_data += struct.pack(BOUNDS_STRUCT_FORMAT,
+                                       glyph.left, glyph.top, glyph.width, glyph.height)
+
     return (intervals_data, glyphs_data, kern_left_data, kern_right_data,
-            kern_matrix_data, ligature_data, bitmap_data)
+            kern_matrix_data, ligature_data, bitmap_data, advances_data, bounds_data)
 
 
 def style_sections_total_size(sections):
@@ -762,7 +783,7 @@ def style_sections_total_size(sections):
 # --- File writers ---
 
 def generate_cpfont_multistyle(style_fonts, size, intervals, output_path,
-                               force_autohint=False):
+                               force_autohint=False, bounds=False):
     """Generate a multi-style v4 .cpfont file.
 
     style_fonts: dict of {style_id: fontfile_path} e.g. {0: "Regular.ttf", 2: "Italic.ttf"}
@@ -770,7 +791,9 @@ def generate_cpfont_multistyle(style_fonts, size, intervals, output_path,
     MAGIC = b"CPFONT\x00\x00"
     HEADER_SIZE = 32
     STYLE_TOC_ENTRY_SIZE = 32
-    flags = 1  # always 2-bit greyscale
+    flags = FLAG_2BIT | FLAG_ADVANCES  # always 2-bit greyscale
+    if bounds:
+        flags |= FLAG_BOUNDS
     style_count = len(style_fonts)
 
     # Rasterize each style
@@ -785,7 +808,7 @@ def generate_cpfont_multistyle(style_fonts, size, intervals, output_path,
     # Pack binary sections for each style
     packed_sections = {}  # style_id -> tuple of section bytearrays
     for style_id, sd in raster_data.items():
-        packed_sections[style_id] = pack_style_sections(sd)
+        packed_sections[style_id] = pack_style_sections(sd, bounds=bounds)
 
     # Calculate data offsets (after header + TOC)
     data_start = HEADER_SIZE + style_count * STYLE_TOC_ENTRY_SIZE
@@ -875,6 +898,8 @@ def main():
                         help="Font family name for output filenames (default: derived from font filename).")
     parser.add_argument("--force-autohint", dest="force_autohint", action="store_true",
                         help="Force FreeType auto-hinter instead of native font hinting.")
+    parser.add_argument("--bounds", dest="bounds", action="store_true",
+                        help="Also store a packed per-glyph ink box section for measurement.")
     parser.add_argument("-o", "--output", dest="output",
                         help="Output file path (for single-size mode).")
     parser.add_argument("--output-dir", dest="output_dir",
@@ -979,7 +1004,7 @@ def main():
         print(f"Generating {output_path} (size {sz}, {len(style_fonts)} style(s), v4)...", file=sys.stderr)
         total_size += generate_cpfont_multistyle(
             style_fonts, sz, intervals, output_path,
-            force_autohint=args.force_autohint)
+            force_autohint=args.force_autohint, bounds=args.bounds)
     print(f"\nTotal: {len(sizes)} files, {total_size / 1024 / 1024:.2f} MB", file=sys.stderr)
 
 
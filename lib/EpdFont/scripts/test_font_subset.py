@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""
+Tests of the font subsetting helpers.
+
+Usage:
+    cd lib/EpdFont/scripts && python -m unittest test_font_subset
+"""
+import os
+import tempfile
+import unittest
+
+from font_subset import (SUBSET_ALWAYS_KEEP, parse_code_point, parse_subset_whitelist, read_subset_whitelist,
+                         subset_intervals, subset_keep)
+
+
+class ParseCodePointTest(unittest.TestCase):
+    def test_notations(self):
+        self.assertEqual(parse_code_point("U+00E9"), 0xE9)
+        self.assertEqual(parse_code_point("u+00e9"), 0xE9)
+        self.assertEqual(parse_code_point("0xE9"), 0xE9)
+        self.assertEqual(parse_code_point("233"), 0xE9)
+        self.assertEqual(parse_code_point("U+10FFFF"), 0x10FFFF)
+
+    def test_rejects_garbage_and_out_of_range(self):
+        for token in ["", "U+", "é", "U+XYZ", "0x110000", "U+110000"]:
+            with self.assertRaises(ValueError, msg=token):
+                parse_code_point(token)
+
+
+class ParseWhitelistTest(unittest.TestCase):
+    def test_tokens_ranges_and_comments(self):
+        lines = [
+            "# Latin-1 letters used by the UI\n",
+            "U+00C0-U+00C2, U+00E9  # accented\n",
+            "\n",
+            "0x2014 8230\n",
+            "U+0400-0x0402\n",
+        ]
+        self.assertEqual(parse_subset_whitelist(lines), {0xC0, 0xC1, 0xC2, 0xE9, 0x2014, 0x2026, 0x400, 0x401, 0x402})
+
+    def test_single_point_range(self):
+        self.assertEqual(parse_subset_whitelist(["U+0041-U+0041"]), {0x41})
+
+    def test_errors_name_the_line(self):
+        with self.assertRaisesRegex(ValueError, r"codepoints.txt:2: bad code point token 'U\+00G0'"):
+            parse_subset_whitelist(["U+0041\n", "U+00G0\n"], "codepoints.txt")
+        with self.assertRaisesRegex(ValueError, r"<whitelist>:1: reversed range"):
+            parse_subset_whitelist(["U+005A-U+0041"])
+        with self.assertRaisesRegex(ValueError, r"<whitelist>:1: bad code point token '-U\+0041'"):
+            parse_subset_whitelist(["-U+0041"])
+        with self.assertRaisesRegex(ValueError, r"<whitelist>:1: bad code point token 'U\+0041-'"):
+            parse_subset_whitelist(["U+0041-"])
+
+
+class SubsetTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def write(self, name, text):
+        path = os.path.join(self.dir.name, name)
+        with open(path, "w", encoding="utf-8") as f:
+            f.write(text)
+        return path
+
+    def test_keep_combines_whitelists_corpora_and_the_always_kept_set(self):
+        whitelist = self.write("codepoints.txt", "U+00E9\n")
+        corpus = self.write("book.txt", "Привет — «мир»")
+        keep = subset_keep([whitelist], [corpus])
+
+        for start, end in SUBSET_ALWAYS_KEEP:
+            self.assertTrue(set(range(start, end + 1)) <= keep)
+        self.assertIn(0xE9, keep)
+        self.assertTrue({ord(c) for c in "Привет—«»"} <= keep)
+        self.assertNotIn(0xE8, keep)
+        self.assertEqual(read_subset_whitelist(whitelist), {0xE9})
+
+    def test_intervals_are_clipped_to_the_font_and_merged(self):
+        ranges = [(0x20, 0x7E), (0xA0, 0xFF)]
+        keep = {0x41, 0x42, 0x43, 0x45, 0x7E, 0xA0, 0xFF, 0x100, 0x400}
+        self.assertEqual(subset_intervals(ranges, keep), [(0x41, 0x43), (0x45, 0x45), (0x7E, 0x7E), (0xA0, 0xA0),
+                                                         (0xFF, 0xFF)])
+
+    def test_adjacent_font_ranges_merge_into_one_interval(self):
+        self.assertEqual(subset_intervals([(0x20, 0x7F), (0x80, 0xFF)], set(range(0x70, 0x90))), [(0x70, 0x8F)])
+
+    def test_nothing_kept(self):
+        self.assertEqual(subset_intervals([(0x20, 0x7E)], set()), [])
+        self.assertEqual(subset_intervals([(0x20, 0x7E)], {0x10, 0x7F}), [])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -80,6 +80,11 @@ void HalDisplay::refreshDisplay(HalDisplay::RefreshMode mode,
   einkDisplay.refreshDisplay(convertRefreshMode(mode), turnOffScreen);
 }
 
+void HalDisplay::displayWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                               bool turnOffScreen) {
+  einkDisplay.displayWindow(x, y, w, h, turnOffScreen);
+}
+
 void HalDisplay::deepSleep() { einkDisplay.deepSleep(); }
 
 uint8_t *HalDisplay::getFrameBuffer() const {
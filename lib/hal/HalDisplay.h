@@ -43,6 +43,9 @@ public:
                      bool turnOffScreen = false);
   void refreshDisplay(RefreshMode mode = RefreshMode::FAST_REFRESH,
                       bool turnOffScreen = false);
+  // Push and fast-refresh a byte-aligned window (x and w multiples of 8)
+  void displayWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                     bool turnOffScreen = false);
 
   // Power management
   void deepSleep();
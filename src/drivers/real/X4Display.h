@@ -22,6 +22,20 @@ class X4Display : public Display {
     hal.refreshDisplay(convertMode(mode), turnOffScreen);
   }
 
+  bool displayGrayBuffer(const uint8_t* lsb, const uint8_t* msb) override {
+    hal.copyGrayscaleLsbBuffers(lsb);
+    hal.copyGrayscaleMsbBuffers(msb);
+    hal.displayGrayBuffer(turnOffScreen);
+    // The framebuffer still holds the black/white frame, rebuild the controller's previous-frame RAM from it
+    hal.cleanupGrayscaleBuffers(hal.getFrameBuffer());
+    return true;
+  }
+
+ protected:
+  void displayWindow(const Region& r) override {
+    hal.displayWindow(r.x, r.y, r.w, r.h, turnOffScreen);
+  }
+
  private:
   HalDisplay hal;
 
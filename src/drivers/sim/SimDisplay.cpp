@@ -26,7 +26,7 @@ uint16_t SimDisplay::getWidth() const { return (uint16_t)w; }
 uint16_t SimDisplay::getHeight() const { return (uint16_t)h; }
 uint16_t SimDisplay::getWidthBytes() const { return (uint16_t)(w / 8); }
 
-void SimDisplay::displayBuffer(RefreshMode /*mode*/) {
+void SimDisplay::present(const uint8_t* lsb, const uint8_t* msb) {
   // Window is h×w (portrait). Apply inverse of Portrait rotation to map physical
   // framebuffer (w×h landscape) to the portrait window for display.
   // Portrait forward:  phyX = logY,  phyY = h-1-logX
@@ -39,16 +39,54 @@ void SimDisplay::displayBuffer(RefreshMode /*mode*/) {
       const bool isBlack = !((framebuffer[byteIdx] >> bitPos) & 1);
       const int winX = h - 1 - phyY;
       const int winY = phyX;
-      pixels[(size_t)winY * h + winX] = isBlack ? 0xFF000000u : 0xFFFFFFFFu;
+      uint32_t color = isBlack ? 0xFF000000u : 0xFFFFFFFFu;
+      if (isBlack && msb && ((msb[byteIdx] >> bitPos) & 1)) {
+        color = ((lsb[byteIdx] >> bitPos) & 1) ? 0xFF555555u : 0xFFAAAAAAu;  // dark / light gray
+      }
+      pixels[(size_t)winY * h + winX] = color;
     }
   }
   SDL_UpdateTexture(texture, nullptr, pixels.data(), h * (int)sizeof(uint32_t));
   SDL_RenderClear(renderer);
   SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+
+  // Outline the refreshed windows (converted to window coordinates like the pixels above)
+  SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0x00, 0xFF);
+  for (const Region& r : damageOverlay) {
+    const SDL_Rect outline{h - r.y - r.h, r.x, r.h, r.w};
+    SDL_RenderDrawRect(renderer, &outline);
+  }
+  SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
+
   SDL_RenderPresent(renderer);
+}
+
+void SimDisplay::displayBuffer(RefreshMode /*mode*/) {
+  damageOverlay.clear();
+  present();
   printf("[SimDisplay] turnOffScreen: %s\n", turnOffScreen ? "true" : "false");
 }
 
+void SimDisplay::displayRegions(const Region* regions, uint8_t count, RefreshMode mode) {
+  uint32_t area = 0;
+  for (uint8_t i = 0; i < count; i++) area += (uint32_t)regions[i].w * regions[i].h;
+  printf("[SimDisplay] damage: %u regions, %u%% of panel\n", count, (unsigned)(area * 100 / ((uint32_t)w * h)));
+  damageOverlay.clear();
+  Display::displayRegions(regions, count, mode);
+}
+
+bool SimDisplay::displayGrayBuffer(const uint8_t* lsb, const uint8_t* msb) {
+  damageOverlay.clear();
+  present(lsb, msb);
+  printf("[SimDisplay] grayscale overlay\n");
+  return true;
+}
+
+void SimDisplay::displayWindow(const Region& region) {
+  damageOverlay.push_back(region);
+  present();
+}
+
 void SimDisplay::refreshDisplay(RefreshMode mode) {
   displayBuffer(mode);
 }
@@ -21,6 +21,8 @@ class SimDisplay : public Display {
 
   void displayBuffer(RefreshMode mode = FAST_REFRESH) override;
   void refreshDisplay(RefreshMode mode = FAST_REFRESH) override;
+  void displayRegions(const Region* regions, uint8_t count, RefreshMode mode = FAST_REFRESH) override;
+  bool displayGrayBuffer(const uint8_t* lsb, const uint8_t* msb) override;
 
   bool shouldClose() const;
   void pollEvents();
@@ -32,6 +34,15 @@ class SimDisplay : public Display {
   SDL_Renderer* renderer = nullptr;
   SDL_Texture* texture = nullptr;
   bool closed = false;
+
+  // Windows pushed by the current displayRegions() call, outlined on screen to visualize the damage
+  std::vector<Region> damageOverlay;
+
+  // Gray planes, when given, shade the black pixels they mark like the panel's gray LUT would
+  void present(const uint8_t* lsb = nullptr, const uint8_t* msb = nullptr);
+
+ protected:
+  void displayWindow(const Region& region) override;
 };
 
 #endif  // SIMULATOR
@@ -1,4 +1,8 @@
-#ifdef SIMULATOR
+#ifdef PIO_UNIT_TESTING
+
+// Native tests under test/ bring their own main()
+
+#elif defined(SIMULATOR)
 
 #include <os/os.h>
 #include <os/graphic/Fonts.h>
@@ -23,7 +27,7 @@ int main() {
   const int y = (g.getHeight() - th) / 2;
   g.drawText(text, x, y, opts);
 
-  simDisplay.displayBuffer();
+  g.displayBuffer();
 
   while (!simDisplay.shouldClose()) {
     simDisplay.pollEvents();
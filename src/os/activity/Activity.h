@@ -10,6 +10,8 @@
 #include "ActivityResult.h"
 #include "RenderLock.h"
 
+class Widget; // forward declaration
+
 class Activity {
   friend class ActivityManager;
 
@@ -28,6 +30,13 @@ public:
 
   virtual void render(RenderLock &&) {}
 
+  // Optional retained widget tree. If the activity returns one, the render
+  // task repaints only the invalidated widgets and refreshes just the damaged
+  // region of the display, and render() is not called: draw custom content
+  // from a Widget's draw() instead. Mutate the widgets while holding a
+  // RenderLock, then requestUpdate().
+  virtual Widget *getRootWidget() { return nullptr; }
+
   // If immediate is true, the update will be triggered immediately.
   // Otherwise, it will be deferred until the end of the current loop iteration.
   virtual void requestUpdate(bool immediate = false);
@@ -3,6 +3,7 @@
 #include "RenderLock.h"
 
 #include <os/graphic/Graphic.h>
+#include <os/graphic/Widget.h>
 
 Graphic& ActivityManager::getGraphic() { return Graphic::getInstance(); }
 
@@ -35,7 +36,11 @@ void ActivityManager::renderTaskLoop() {
     if (currentActivity) {
       HalPowerManager::Lock
           powerLock; // Ensure we don't go into low-power mode while rendering
-      currentActivity->render(std::move(lock));
+      if (paintWidgets()) {
+        lock.unlock();
+      } else {
+        currentActivity->render(std::move(lock));
+      }
     }
     // Notify any task blocked in requestUpdateAndWait() that the render is
     // done.
@@ -50,6 +55,26 @@ void ActivityManager::renderTaskLoop() {
   }
 }
 
+bool ActivityManager::paintWidgets() {
+  // Note: the rendering mutex must be held by the caller
+  Widget *root = currentActivity->getRootWidget();
+  if (root == nullptr) {
+    paintedActivity = nullptr;
+    return false;
+  }
+  const bool full = paintedActivity != currentActivity.get();
+  if (!full && !root->needsPaint()) {
+    return true;
+  }
+  Graphic &gfx = getGraphic();
+  if (!root->paint(gfx, full)) {
+    LOG_ERR("ACT", "Widget tree nested deeper than the clip stack");
+  }
+  gfx.displayDamage();
+  paintedActivity = currentActivity.get();
+  return true;
+}
+
 void ActivityManager::loop() {
   if (currentActivity) {
     // Note: do not hold a lock here, the loop() method must be responsible for
@@ -153,6 +178,8 @@ void ActivityManager::exitActivity(const RenderLock &lock) {
   if (currentActivity) {
     currentActivity->onExit();
     currentActivity.reset();
+    // A later activity may be allocated at the same address
+    paintedActivity = nullptr;
   }
 }
 
@@ -55,6 +55,13 @@ protected:
   static void renderTaskTrampoline(void *param);
   [[noreturn]] virtual void renderTaskLoop();
 
+  // Activity whose widget tree is currently on screen; any other tree gets a
+  // full repaint first. Only accessed while holding the rendering mutex.
+  Activity *paintedActivity = nullptr;
+  // Repaints and refreshes the current activity's widget tree. Returns false
+  // if the activity has none and draws itself in render().
+  bool paintWidgets();
+
   // Set by requestUpdateAndWait(); read and cleared by the render task after
   // render completes. Note: only one waiting task is supported at a time
   TaskHandle_t waitingTaskHandle = nullptr;
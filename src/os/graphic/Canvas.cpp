@@ -0,0 +1,51 @@
+#include "Canvas.h"
+
+#include <os/internal.h>
+
+#include <cstdlib>
+#include <cstring>
+
+Canvas::~Canvas() { free(buffer); }
+
+bool Canvas::allocate(int w, int h, Graphic::Orientation o) {
+  release();
+  if (w <= 0 || h <= 0) return false;
+
+  const bool portrait = o == Graphic::Portrait || o == Graphic::PortraitInverted;
+  const uint16_t pw = portrait ? h : w;
+  const uint16_t ph = portrait ? w : h;
+  const uint16_t wb = (pw + 7) / 8;
+  buffer = static_cast<uint8_t*>(malloc(bufferSize(w, h, o)));
+  if (!buffer) {
+    LOG_ERR("GFX", "Failed to allocate %dx%d canvas", w, h);
+    return false;
+  }
+
+  width = w;
+  height = h;
+  phyW = pw;
+  phyH = ph;
+  widthBytes = wb;
+  layout = o;
+  clear();
+  return true;
+}
+
+uint32_t Canvas::bufferSize(int w, int h, Graphic::Orientation o) {
+  if (w <= 0 || h <= 0) return 0;
+  const bool portrait = o == Graphic::Portrait || o == Graphic::PortraitInverted;
+  return static_cast<uint32_t>(((portrait ? h : w) + 7) / 8) * (portrait ? w : h);
+}
+
+void Canvas::release() {
+  free(buffer);
+  buffer = nullptr;
+  width = height = phyW = phyH = widthBytes = 0;
+  version++;
+}
+
+void Canvas::clear(bool black) {
+  if (!buffer) return;
+  memset(buffer, black ? 0x00 : 0xFF, static_cast<uint32_t>(widthBytes) * phyH);  // 0 = black on E-Ink
+  version++;
+}
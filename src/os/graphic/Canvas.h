@@ -0,0 +1,41 @@
+#pragma once
+
+#include <os/graphic/Graphic.h>
+
+#include <cstdint>
+
+// Off-screen 1-bit surface that Graphic can render into (Graphic::setTarget) and composite onto the screen
+// (Graphic::drawCanvas). Pixels are stored in the physical layout of the orientation the canvas was created
+// for, so compositing is a plain translation with whole-byte copies. Create canvases with
+// Graphic::createCanvas() to get the layout matching the screen.
+class Canvas {
+ public:
+  Canvas() = default;
+  ~Canvas();
+  Canvas(const Canvas&) = delete;
+  Canvas& operator=(const Canvas&) = delete;
+
+  // Logical size is width x height. Returns false if the buffer could not be allocated.
+  bool allocate(int width, int height, Graphic::Orientation layout);
+  // Bytes allocate() takes for the buffer
+  static uint32_t bufferSize(int width, int height, Graphic::Orientation layout);
+  void release();
+  bool valid() const { return buffer != nullptr; }
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  Graphic::Orientation getLayout() const { return layout; }
+  // Bumped whenever the content may have changed; lets retained frames tell re-rendered canvases apart
+  uint32_t getVersion() const { return version; }
+
+  void clear(bool black = false);
+
+ private:
+  friend class Graphic;
+
+  uint8_t* buffer = nullptr;
+  uint16_t width = 0, height = 0;           // logical size
+  uint16_t phyW = 0, phyH = 0, widthBytes = 0;  // physical geometry of the buffer
+  Graphic::Orientation layout = Graphic::LandscapeCounterClockwise;
+  uint32_t version = 0;
+};
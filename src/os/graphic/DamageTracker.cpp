@@ -0,0 +1,72 @@
+#include "DamageTracker.h"
+
+#include <algorithm>
+
+static inline uint32_t regionArea(const Display::Region& r) { return static_cast<uint32_t>(r.w) * r.h; }
+
+// Rectangles closer than this count as touching, so the glyphs of a line collapse into one region
+static constexpr int MERGE_GAP = 8;
+
+static inline bool touches(const Display::Region& a, const Display::Region& b) {
+  return a.x <= b.x + b.w + MERGE_GAP && b.x <= a.x + a.w + MERGE_GAP && a.y <= b.y + b.h + MERGE_GAP &&
+         b.y <= a.y + a.h + MERGE_GAP;
+}
+
+static inline Display::Region unite(const Display::Region& a, const Display::Region& b) {
+  const uint16_t x0 = std::min(a.x, b.x);
+  const uint16_t y0 = std::min(a.y, b.y);
+  const uint16_t x1 = std::max(a.x + a.w, b.x + b.w);
+  const uint16_t y1 = std::max(a.y + a.h, b.y + b.h);
+  return {x0, y0, static_cast<uint16_t>(x1 - x0), static_cast<uint16_t>(y1 - y0)};
+}
+
+void DamageTracker::add(int x, int y, int w, int h, uint16_t panelW, uint16_t panelH) {
+  // Snapping would otherwise widen an empty rectangle to a whole byte column
+  if (w <= 0 || h <= 0) return;
+  int x0 = std::max(x, 0) & ~7;
+  int x1 = std::min((x + w + 7) & ~7, static_cast<int>(panelW));
+  int y0 = std::max(y, 0);
+  int y1 = std::min(y + h, static_cast<int>(panelH));
+  if (x0 >= x1 || y0 >= y1) return;
+
+  insert({static_cast<uint16_t>(x0), static_cast<uint16_t>(y0), static_cast<uint16_t>(x1 - x0),
+          static_cast<uint16_t>(y1 - y0)});
+}
+
+void DamageTracker::insert(Display::Region r) {
+  // Absorb every region the new one touches; the union may now touch others, so rescan
+  for (uint8_t i = 0; i < count;) {
+    if (touches(regions[i], r)) {
+      r = unite(regions[i], r);
+      regions[i] = regions[--count];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  if (count < MAX_REGIONS) {
+    regions[count++] = r;
+    return;
+  }
+
+  // Full: fold the new region into whichever existing one grows the least
+  uint8_t best = 0;
+  uint32_t bestGrowth = UINT32_MAX;
+  for (uint8_t i = 0; i < count; i++) {
+    const uint32_t growth = regionArea(unite(regions[i], r)) - regionArea(regions[i]);
+    if (growth < bestGrowth) {
+      bestGrowth = growth;
+      best = i;
+    }
+  }
+  r = unite(regions[best], r);
+  regions[best] = regions[--count];
+  insert(r);
+}
+
+uint32_t DamageTracker::area() const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < count; i++) total += regionArea(regions[i]);
+  return total;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <os/hw/Display.h>
+
+#include <cstdint>
+
+// Small set of damaged framebuffer rectangles in physical panel coordinates. Rectangles are snapped to the
+// 8-pixel byte grid horizontally (as required by Display::displayRegions) and merged whenever they touch
+// or nearly touch, so the set stays tiny. When it is full, the two rectangles whose union grows the least are merged.
+class DamageTracker {
+ public:
+  static constexpr uint8_t MAX_REGIONS = 8;
+
+  void add(int x, int y, int w, int h, uint16_t panelW, uint16_t panelH);
+  void addAll(uint16_t panelW, uint16_t panelH) { add(0, 0, panelW, panelH, panelW, panelH); }
+  void clear() { count = 0; }
+
+  bool empty() const { return count == 0; }
+  uint8_t size() const { return count; }
+  const Display::Region* data() const { return regions; }
+  uint32_t area() const;
+
+ private:
+  Display::Region regions[MAX_REGIONS] = {};
+  uint8_t count = 0;
+
+  void insert(Display::Region r);
+};
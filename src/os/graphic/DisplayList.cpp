@@ -0,0 +1,130 @@
+#include "DisplayList.h"
+
+#include <os/graphic/LruCache.h>
+
+bool DisplayList::Command::equals(const Command& other) const {
+  return hash == other.hash && op == other.op && payloadSize == other.payloadSize && x == other.x &&
+         y == other.y && w == other.w && h == other.h && clip.x0 == other.clip.x0 && clip.y0 == other.clip.y0 &&
+         clip.x1 == other.clip.x1 && clip.y1 == other.clip.y1 && memcmp(payload(), other.payload(), payloadSize) == 0;
+}
+
+BoxOpts DisplayList::Command::boxOpts() const {
+  BoxRecord record;
+  memcpy(&record, payload(), sizeof(record));
+  BoxOpts opts;
+  opts.fill = record.fill;
+  opts.black = record.black;
+  opts.border.top = record.top;
+  opts.border.right = record.right;
+  opts.border.bottom = record.bottom;
+  opts.border.left = record.left;
+  return opts;
+}
+
+TextOpts DisplayList::Command::textOpts() const {
+  TextRecord record;
+  memcpy(&record, payload(), sizeof(record));
+  TextOpts opts;
+  opts.font = record.font;
+  opts.black = record.black;
+  opts.style = record.style;
+  return opts;
+}
+
+DisplayList::ShapeRef DisplayList::Command::shapeRef() const {
+  ShapeRecord record;
+  memcpy(&record, payload(), sizeof(record));
+  ShapeRef ref;
+  ref.kind = record.kind;
+  ref.opts.fill = record.fill;
+  ref.opts.black = record.black;
+  ref.opts.stroke = record.stroke;
+  ref.radius = record.radius;
+  ref.startAngle = record.startAngle;
+  ref.endAngle = record.endAngle;
+  return ref;
+}
+
+void DisplayList::clear() {
+  arena.clear();
+  offsets.clear();
+}
+
+void DisplayList::addBox(int x, int y, int w, int h, const BoxOpts& opts, const Bounds& bounds,
+                         const Bounds& clip) {
+  BoxRecord record;
+  memset(&record, 0, sizeof(record));
+  record.fill = opts.fill;
+  record.black = opts.black;
+  record.top = opts.border.top;
+  record.right = opts.border.right;
+  record.bottom = opts.border.bottom;
+  record.left = opts.border.left;
+  add(Op::Box, x, y, w, h, bounds, clip, &record, sizeof(record), nullptr, 0);
+}
+
+void DisplayList::addText(const char* text, int x, int y, const TextOpts& opts, const Bounds& bounds,
+                          const Bounds& clip, Op op) {
+  TextRecord record;
+  memset(&record, 0, sizeof(record));
+  record.font = opts.font;
+  record.black = opts.black;
+  record.style = opts.style;
+  add(op, x, y, 0, 0, bounds, clip, &record, sizeof(record), text, static_cast<uint16_t>(strlen(text) + 1));
+}
+
+void DisplayList::addInvert(int x, int y, int w, int h, const Bounds& bounds, const Bounds& clip) {
+  add(Op::Invert, x, y, w, h, bounds, clip, nullptr, 0, nullptr, 0);
+}
+
+void DisplayList::addShape(const ShapeRef& shape, int x, int y, int w, int h, const Bounds& bounds,
+                           const Bounds& clip) {
+  ShapeRecord record;
+  memset(&record, 0, sizeof(record));
+  record.kind = shape.kind;
+  record.fill = shape.opts.fill;
+  record.black = shape.opts.black;
+  record.stroke = shape.opts.stroke;
+  record.radius = shape.radius;
+  record.startAngle = shape.startAngle;
+  record.endAngle = shape.endAngle;
+  add(Op::Shape, x, y, w, h, bounds, clip, &record, sizeof(record), nullptr, 0);
+}
+
+void DisplayList::addCanvas(const ::Canvas* canvas, uint32_t version, int x, int y, int w, int h, Composite mode,
+                            const Bounds& bounds, const Bounds& clip) {
+  CanvasRef packed;
+  memset(&packed, 0, sizeof(packed));
+  packed.canvas = canvas;
+  packed.version = version;
+  packed.mode = mode;
+  add(Op::Canvas, x, y, w, h, bounds, clip, &packed, sizeof(packed), nullptr, 0);
+}
+
+void DisplayList::add(Op op, int x, int y, int w, int h, const Bounds& bounds, const Bounds& clip,
+                      const void* payload1, uint16_t size1, const void* payload2, uint16_t size2) {
+  Command cmd;
+  cmd.op = op;
+  cmd.payloadSize = size1 + size2;
+  cmd.x = x;
+  cmd.y = y;
+  cmd.w = w;
+  cmd.h = h;
+  cmd.bounds = bounds;
+  cmd.clip = clip;
+
+  uint32_t hash = fnv1a::bytes(fnv1a::OFFSET_BASIS, &op, sizeof(op));
+  const int args[] = {x, y, w, h, clip.x0, clip.y0, clip.x1, clip.y1};
+  hash = fnv1a::bytes(hash, args, sizeof(args));
+  if (size1) hash = fnv1a::bytes(hash, payload1, size1);
+  if (size2) hash = fnv1a::bytes(hash, payload2, size2);
+  cmd.hash = hash;
+
+  // Keep every record aligned for the Command header
+  const uint32_t offset = (arena.size() + alignof(Command) - 1) & ~(alignof(Command) - 1);
+  arena.resize(offset + sizeof(Command) + cmd.payloadSize);
+  memcpy(&arena[offset], &cmd, sizeof(cmd));
+  if (size1) memcpy(&arena[offset + sizeof(Command)], payload1, size1);
+  if (size2) memcpy(&arena[offset + sizeof(Command) + size1], payload2, size2);
+  offsets.push_back(offset);
+}
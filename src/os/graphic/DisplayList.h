@@ -0,0 +1,103 @@
+#pragma once
+
+#include <os/graphic/DrawOpts.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class Canvas;
+
+// Draw calls recorded by Graphic in retained mode. Commands are packed back to back into a single
+// arena: a fixed header followed by the op-specific payload (options, then the NUL-terminated string
+// for text). The arena and index keep their capacity across frames, so steady-state recording does
+// not allocate.
+class DisplayList {
+ public:
+  enum class Op : uint8_t { Box, Text, Canvas, Invert, Shape, Label };
+
+  // Canvases are recorded by reference; the version makes a re-rendered canvas compare as changed
+  struct CanvasRef {
+    const ::Canvas* canvas;
+    uint32_t version;
+    Composite mode;
+  };
+
+  // Vector primitive. The command's x, y, w, h hold the shape's own arguments: the two endpoints of a
+  // line, the rectangle of a rounded rect, the center of an arc.
+  struct ShapeRef {
+    enum Kind : uint8_t { Line, RoundRect, Arc } kind;
+    ShapeOpts opts;
+    int16_t radius;
+    int16_t startAngle, endAngle;
+  };
+
+  // Logical rectangle [x0, x1) x [y0, y1) covering everything a command may touch
+  struct Bounds {
+    int x0, y0, x1, y1;
+  };
+
+  struct Command {
+    Op op;
+    uint16_t payloadSize;
+    uint32_t hash;  // over op, arguments and payload; equal commands are confirmed with memcmp
+    int x, y, w, h;
+    Bounds bounds;  // already intersected with clip
+    Bounds clip;    // clip rectangle in effect when the command was recorded
+
+    BoxOpts boxOpts() const;
+    TextOpts textOpts() const;
+    CanvasRef canvasRef() const {
+      CanvasRef ref;
+      memcpy(&ref, payload(), sizeof(ref));
+      return ref;
+    }
+    ShapeRef shapeRef() const;
+    const char* text() const { return reinterpret_cast<const char*>(payload()) + sizeof(TextRecord); }
+    bool equals(const Command& other) const;
+
+   private:
+    const uint8_t* payload() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+  };
+
+  void clear();
+  bool empty() const { return offsets.empty(); }
+  uint32_t size() const { return offsets.size(); }
+  const Command& operator[](uint32_t i) const { return *reinterpret_cast<const Command*>(&arena[offsets[i]]); }
+
+  void addBox(int x, int y, int w, int h, const BoxOpts& opts, const Bounds& bounds, const Bounds& clip);
+  // Label commands are text drawn through the label cache, with the same payload
+  void addText(const char* text, int x, int y, const TextOpts& opts, const Bounds& bounds, const Bounds& clip,
+               Op op = Op::Text);
+  void addInvert(int x, int y, int w, int h, const Bounds& bounds, const Bounds& clip);
+  void addShape(const ShapeRef& shape, int x, int y, int w, int h, const Bounds& bounds, const Bounds& clip);
+  // The canvas must outlive every frame that references it
+  void addCanvas(const ::Canvas* canvas, uint32_t version, int x, int y, int w, int h, Composite mode,
+                 const Bounds& bounds, const Bounds& clip);
+
+ private:
+  // Payloads of box, text and shape commands. Unlike the option structs these are trivially copyable, so they are
+  // zeroed before filling and padding bytes never make equal commands hash or compare differently.
+  struct BoxRecord {
+    bool fill, black;
+    uint8_t top, right, bottom, left;
+  };
+  struct TextRecord {
+    const EpdFontFamily* font;
+    bool black;
+    EpdFontFamily::Style style;
+  };
+  struct ShapeRecord {
+    ShapeRef::Kind kind;
+    bool fill, black;
+    uint8_t stroke;
+    int16_t radius;
+    int16_t startAngle, endAngle;
+  };
+
+  std::vector<uint8_t> arena;
+  std::vector<uint32_t> offsets;
+
+  void add(Op op, int x, int y, int w, int h, const Bounds& bounds, const Bounds& clip, const void* payload1,
+           uint16_t size1, const void* payload2, uint16_t size2);
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <EpdFontFamily.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Logical rectangle
+struct Rect {
+  int x = 0, y = 0, w = 0, h = 0;
+};
+
+struct BoxOpts {
+  struct Border {
+    uint8_t top = 1, right = 1, bottom = 1, left = 1;
+    Border() = default;
+    explicit Border(uint8_t all) : top(all), right(all), bottom(all), left(all) {}
+  };
+  bool fill = false;
+  bool black = true;
+  Border border;
+};
+
+// Options for Graphic's vector primitives
+struct ShapeOpts {
+  bool fill = false;  // closed shapes only
+  bool black = true;
+  uint8_t stroke = 1;  // line and outline thickness
+};
+
+struct TextOpts {
+  const EpdFontFamily* font = nullptr;
+  bool black = true;
+  EpdFontFamily::Style style = EpdFontFamily::REGULAR;
+};
+
+// One piece of rich text for Graphic::drawRuns(); runs share the family and color passed there
+struct TextRun {
+  const char* text = nullptr;
+  EpdFontFamily::Style style = EpdFontFamily::REGULAR;
+  int x = 0, y = 0;
+};
+
+// How Graphic::drawCanvas() combines a canvas with what is already on the target
+enum class Composite : uint8_t {
+  Opaque,            // canvas replaces the destination
+  TransparentWhite,  // only black canvas pixels are drawn
+  Xor,               // black canvas pixels invert the destination
+  TransparentBlack,  // only white canvas pixels are drawn
+};
+
+// Encoded PNG or JPEG for Graphic::drawImage(): a file on the SD card, or a buffer that stays valid while
+// it is drawn. The format is detected from the content.
+struct ImageSource {
+  const char* path = nullptr;
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+
+  static ImageSource file(const char* path) {
+    ImageSource source;
+    source.path = path;
+    return source;
+  }
+  static ImageSource memory(const uint8_t* data, size_t size) {
+    ImageSource source;
+    source.data = data;
+    source.size = size;
+    return source;
+  }
+};
+
+// How Graphic::drawImage() scales an image into its rectangle
+enum class ImageFit : uint8_t {
+  Contain,  // keep the aspect ratio, whole image visible, centered
+  Cover,    // keep the aspect ratio, fill the rectangle, overflow cropped evenly
+  Stretch,  // fill the rectangle exactly
+};
@@ -0,0 +1,52 @@
+// The contents of this file are generated by ./lib/EpdFont/scripts/build-font-ids.sh
+#pragma once
+
+#define NOTOSERIF_12_FONT_ID (85340443)
+#define NOTOSERIF_14_FONT_ID (-1367885987)
+#define NOTOSERIF_16_FONT_ID (1428909134)
+#define NOTOSERIF_18_FONT_ID (-501438527)
+#define NOTOSANS_12_FONT_ID (2057568286)
+#define NOTOSANS_14_FONT_ID (-1589315735)
+#define NOTOSANS_16_FONT_ID (1669013660)
+#define NOTOSANS_18_FONT_ID (37077304)
+#define OPENDYSLEXIC_8_FONT_ID (-853313197)
+#define OPENDYSLEXIC_10_FONT_ID (963754926)
+#define OPENDYSLEXIC_12_FONT_ID (858950283)
+#define OPENDYSLEXIC_14_FONT_ID (1877344218)
+#define UI_10_FONT_ID (22918846)
+#define UI_12_FONT_ID (1635686837)
+#define SMALL_FONT_ID (674098198)
+
+// Builtin families as X(id, regular, bold, italic, boldItalic), styles a family lacks being nullptr.
+// IDs of omitted groups stay defined but are not found by findFontFamilyById().
+#ifdef OMIT_NOTOSERIF_FONTS
+#define BUILTIN_NOTOSERIF_FONT_FAMILIES(X)
+#else
+#define BUILTIN_NOTOSERIF_FONT_FAMILIES(X) \
+  X(NOTOSERIF_12_FONT_ID, &notoserif_12_regular, &notoserif_12_bold, &notoserif_12_italic, &notoserif_12_bolditalic) \
+  X(NOTOSERIF_14_FONT_ID, &notoserif_14_regular, &notoserif_14_bold, &notoserif_14_italic, &notoserif_14_bolditalic) \
+  X(NOTOSERIF_16_FONT_ID, &notoserif_16_regular, &notoserif_16_bold, &notoserif_16_italic, &notoserif_16_bolditalic) \
+  X(NOTOSERIF_18_FONT_ID, &notoserif_18_regular, &notoserif_18_bold, &notoserif_18_italic, &notoserif_18_bolditalic) \
+
+#endif
+#ifdef OMIT_OPENDYSLEXIC_FONTS
+#define BUILTIN_OPENDYSLEXIC_FONT_FAMILIES(X)
+#else
+#define BUILTIN_OPENDYSLEXIC_FONT_FAMILIES(X) \
+  X(OPENDYSLEXIC_8_FONT_ID, &opendyslexic_8_regular, &opendyslexic_8_bold, &opendyslexic_8_italic, &opendyslexic_8_bolditalic) \
+  X(OPENDYSLEXIC_10_FONT_ID, &opendyslexic_10_regular, &opendyslexic_10_bold, &opendyslexic_10_italic, &opendyslexic_10_bolditalic) \
+  X(OPENDYSLEXIC_12_FONT_ID, &opendyslexic_12_regular, &opendyslexic_12_bold, &opendyslexic_12_italic, &opendyslexic_12_bolditalic) \
+  X(OPENDYSLEXIC_14_FONT_ID, &opendyslexic_14_regular, &opendyslexic_14_bold, &opendyslexic_14_italic, &opendyslexic_14_bolditalic) \
+
+#endif
+#define BUILTIN_FONT_FAMILIES(X) \
+  X(NOTOSANS_12_FONT_ID, &notosans_12_regular, &notosans_12_bold, &notosans_12_italic, &notosans_12_bolditalic) \
+  X(NOTOSANS_14_FONT_ID, &notosans_14_regular, &notosans_14_bold, &notosans_14_italic, &notosans_14_bolditalic) \
+  X(NOTOSANS_16_FONT_ID, &notosans_16_regular, &notosans_16_bold, &notosans_16_italic, &notosans_16_bolditalic) \
+  X(NOTOSANS_18_FONT_ID, &notosans_18_regular, &notosans_18_bold, &notosans_18_italic, &notosans_18_bolditalic) \
+  X(UI_10_FONT_ID, &ubuntu_10_regular, &ubuntu_10_bold, nullptr, nullptr) \
+  X(UI_12_FONT_ID, &ubuntu_12_regular, &ubuntu_12_bold, nullptr, nullptr) \
+  X(SMALL_FONT_ID, &notosans_8_regular, nullptr, nullptr, nullptr) \
+  BUILTIN_NOTOSERIF_FONT_FAMILIES(X) \
+  BUILTIN_OPENDYSLEXIC_FONT_FAMILIES(X) \
+
@@ -6,42 +6,109 @@
 #include <FontDecompressor.h>
 #include <builtinFonts/all.h>
 
-EpdFont notosans12RegularFont(&notosans_12_regular);
-EpdFont notosans12BoldFont(&notosans_12_bold);
-EpdFont notosans12ItalicFont(&notosans_12_italic);
-EpdFont notosans12BoldItalicFont(&notosans_12_bolditalic);
-EpdFontFamily notosans12FontFamily(&notosans12RegularFont, &notosans12BoldFont, &notosans12ItalicFont,
-                                   &notosans12BoldItalicFont);
-EpdFont notosans14RegularFont(&notosans_14_regular);
-EpdFont notosans14BoldFont(&notosans_14_bold);
-EpdFont notosans14ItalicFont(&notosans_14_italic);
-EpdFont notosans14BoldItalicFont(&notosans_14_bolditalic);
-EpdFontFamily notosans14FontFamily(&notosans14RegularFont, &notosans14BoldFont, &notosans14ItalicFont,
-                                   &notosans14BoldItalicFont);
-EpdFont notosans16RegularFont(&notosans_16_regular);
-EpdFont notosans16BoldFont(&notosans_16_bold);
-EpdFont notosans16ItalicFont(&notosans_16_italic);
-EpdFont notosans16BoldItalicFont(&notosans_16_bolditalic);
-EpdFontFamily notosans16FontFamily(&notosans16RegularFont, &notosans16BoldFont, &notosans16ItalicFont,
-                                   &notosans16BoldItalicFont);
-EpdFont notosans18RegularFont(&notosans_18_regular);
-EpdFont notosans18BoldFont(&notosans_18_bold);
-EpdFont notosans18ItalicFont(&notosans_18_italic);
-EpdFont notosans18BoldItalicFont(&notosans_18_bolditalic);
-EpdFontFamily notosans18FontFamily(&notosans18RegularFont, &notosans18BoldFont, &notosans18ItalicFont,
-                                   &notosans18BoldItalicFont);
+#include <atomic>
+#include <new>
 
-EpdFontFamily& getFontFamilyById(int32_t id) {
-  switch (id) {
-    case NOTOSANS_12_FONT_ID:
-      return notosans12FontFamily;
-    case NOTOSANS_14_FONT_ID:
-      return notosans14FontFamily;
-    case NOTOSANS_16_FONT_ID:
-      return notosans16FontFamily;
-    case NOTOSANS_18_FONT_ID:
-      return notosans18FontFamily;
-    default:
-      assert(false && "Invalid font ID");
+namespace {
+
+struct BuiltinFont {
+  int32_t id;
+  const EpdFontData* regular;
+  const EpdFontData* bold;
+  const EpdFontData* italic;
+  const EpdFontData* boldItalic;
+};
+
+#define BUILTIN_FONT_ENTRY(id, regular, bold, italic, boldItalic) {id, regular, bold, italic, boldItalic},
+constexpr BuiltinFont BUILTIN_FONTS[] = {BUILTIN_FONT_FAMILIES(BUILTIN_FONT_ENTRY)};
+#undef BUILTIN_FONT_ENTRY
+constexpr size_t BUILTIN_FONT_COUNT = sizeof(BUILTIN_FONTS) / sizeof(BUILTIN_FONTS[0]);
+
+// Perfect hash on the font ID: slot = (id * seed) >> (32 - SLOT_BITS), with a seed searched at compile time
+// that sends every builtin ID to its own slot. Twice as many slots as fonts keeps the search short.
+constexpr uint32_t slotBits() {
+  uint32_t bits = 1;
+  while ((1u << bits) < 2 * BUILTIN_FONT_COUNT) bits++;
+  return bits;
+}
+constexpr uint32_t SLOT_BITS = slotBits();
+constexpr uint32_t SLOT_COUNT = 1u << SLOT_BITS;
+constexpr uint8_t NO_FONT = 0xFF;
+static_assert(BUILTIN_FONT_COUNT < NO_FONT, "Too many builtin fonts for the slot table");
+
+constexpr uint32_t slotOf(int32_t id, uint32_t seed) { return (static_cast<uint32_t>(id) * seed) >> (32 - SLOT_BITS); }
+
+constexpr bool isPerfectSeed(uint32_t seed) {
+  bool used[SLOT_COUNT] = {};
+  for (const BuiltinFont& font : BUILTIN_FONTS) {
+    const uint32_t slot = slotOf(font.id, seed);
+    if (used[slot]) return false;
+    used[slot] = true;
+  }
+  return true;
+}
+
+constexpr uint32_t findSeed() {
+  for (uint32_t seed = 0x9E3779B1; seed < 0x9E3779B1 + 2 * 4096; seed += 2) {
+    if (isPerfectSeed(seed)) return seed;
+  }
+  return 0;
+}
+constexpr uint32_t SEED = findSeed();
+static_assert(SEED != 0, "No perfect hash seed for the builtin font IDs, raise SLOT_BITS");
+
+struct SlotTable {
+  uint8_t font[SLOT_COUNT];
+};
+
+constexpr SlotTable buildSlots() {
+  SlotTable table = {};
+  for (uint32_t slot = 0; slot < SLOT_COUNT; slot++) table.font[slot] = NO_FONT;
+  for (uint32_t i = 0; i < BUILTIN_FONT_COUNT; i++) table.font[slotOf(BUILTIN_FONTS[i].id, SEED)] = i;
+  return table;
+}
+constexpr SlotTable SLOTS = buildSlots();
+
+// Fonts and family of one builtin, allocated together on first use. Styles the family lacks keep a
+// placeholder font that is never handed out.
+struct BuiltinFamily {
+  EpdFont fonts[4];
+  EpdFontFamily family;
+
+  explicit BuiltinFamily(const BuiltinFont& f)
+      : fonts{EpdFont(f.regular), EpdFont(f.bold), EpdFont(f.italic), EpdFont(f.boldItalic)},
+        family(&fonts[0], f.bold ? &fonts[1] : nullptr, f.italic ? &fonts[2] : nullptr,
+               f.boldItalic ? &fonts[3] : nullptr) {}
+};
+
+// Zero-initialized, so nothing runs at boot and an unused font costs one pointer of RAM
+std::atomic<BuiltinFamily*> families[BUILTIN_FONT_COUNT];
+
+}  // namespace
+
+EpdFontFamily* findFontFamilyById(int32_t id) {
+  const uint8_t index = SLOTS.font[slotOf(id, SEED)];
+  if (index == NO_FONT || BUILTIN_FONTS[index].id != id) return nullptr;
+
+  BuiltinFamily* family = families[index].load(std::memory_order_acquire);
+  if (family) return &family->family;
+
+  family = new (std::nothrow) BuiltinFamily(BUILTIN_FONTS[index]);
+  if (!family) {
+    LOG_ERR("FNT", "Failed to allocate font family %ld", static_cast<long>(id));
+    return nullptr;
+  }
+  // Another task may have constructed the family concurrently; keep whichever won
+  BuiltinFamily* expected = nullptr;
+  if (!families[index].compare_exchange_strong(expected, family, std::memory_order_acq_rel)) {
+    delete family;
+    return &expected->family;
   }
+  return &family->family;
+}
+
+EpdFontFamily& getFontFamilyById(int32_t id) {
+  EpdFontFamily* family = findFontFamilyById(id);
+  assert(family != nullptr && "Invalid font ID");
+  return *family;
 }
@@ -1,8 +1,10 @@
-#include <EpdFontFamily.h>
+#pragma once
 
-#define NOTOSANS_12_FONT_ID (2057568286)
-#define NOTOSANS_14_FONT_ID (-1589315735)
-#define NOTOSANS_16_FONT_ID (1669013660)
-#define NOTOSANS_18_FONT_ID (37077304)
+#include <EpdFontFamily.h>
+#include <os/graphic/FontIds.h>
 
+// Builtin family of a *_FONT_ID. The family is constructed on first use and lives for the rest of the run.
 EpdFontFamily& getFontFamilyById(int32_t id);
+// Same, but nullptr for IDs that are not builtin (e.g. a font ID read from settings) or whose group the
+// build omits with -DOMIT_<GROUP>_FONTS
+EpdFontFamily* findFontFamilyById(int32_t id);
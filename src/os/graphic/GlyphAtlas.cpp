@@ -0,0 +1,64 @@
+#include "GlyphAtlas.h"
+
+#include <os/graphic/GlyphCoverage.h>
+#include <os/internal.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+uint32_t GlyphAtlas::hashOf(const EpdFontData* fontData, uint32_t glyphIndex) {
+  const uint32_t h = (static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fontData)) >> 2) ^ (glyphIndex * 2654435761u);
+  return h ^ (h >> 16);
+}
+
+bool GlyphAtlas::contains(const EpdFontData* fontData, uint32_t glyphIndex) const {
+  return cache.peek(hashOf(fontData, glyphIndex), [&](const Entry& entry) {
+    return entry.fontData == fontData && entry.glyphIndex == glyphIndex;
+  }) != nullptr;
+}
+
+const uint8_t* GlyphAtlas::find(const EpdFontData* fontData, uint32_t glyphIndex) {
+  Entry* e = cache.find(hashOf(fontData, glyphIndex), [&](const Entry& entry) {
+    return entry.fontData == fontData && entry.glyphIndex == glyphIndex;
+  });
+  return e ? e->mask() : nullptr;
+}
+
+const uint8_t* GlyphAtlas::insert(const EpdFontData* fontData, uint32_t glyphIndex, const EpdGlyph* glyph,
+                                  const uint8_t* bitmap) {
+  const uint32_t rowBytes = (glyph->width + 7) / 8;
+  const uint32_t size = sizeof(Entry) + rowBytes * glyph->height;
+  if (!cache.reserve(size)) return nullptr;
+
+  void* memory = malloc(size);
+  if (!memory) {
+    LOG_ERR("ATLAS", "Failed to allocate %lu bytes for glyph %lu", size, glyphIndex);
+    return nullptr;
+  }
+  auto* e = new (memory) Entry;
+  e->fontData = fontData;
+  e->glyphIndex = glyphIndex;
+
+  uint8_t row[glyphCoverage::MAX_ROW_BYTES];
+  uint8_t* dst = e->mask();
+  for (int gy = 0; gy < glyph->height; gy++, dst += rowBytes) {
+    if (fontData->is2Bit) {
+      glyphCoverage::extractRow<true>(bitmap, glyph->dataLength, glyph->width, 0, glyph->width, gy, row);
+    } else {
+      glyphCoverage::extractRow<false>(bitmap, glyph->dataLength, glyph->width, 0, glyph->width, gy, row);
+    }
+    memcpy(dst, row, rowBytes);
+  }
+
+  cache.add(e, hashOf(fontData, glyphIndex), size);
+  return e->mask();
+}
+
+void GlyphAtlas::logStats(const char* label) const {
+  const Stats& stats = cache.getStats();
+  const uint32_t total = stats.hits + stats.misses;
+  LOG_DBG("ATLAS", "[%s] hits=%lu misses=%lu (%.1f%% hit rate) evictions=%lu", label, stats.hits, stats.misses,
+          total > 0 ? 100.0f * stats.hits / total : 0.0f, stats.evictions);
+  LOG_DBG("ATLAS", "[%s] glyphs=%u bytes=%lu/%lu", label, stats.entries, stats.bytes, cache.getBudget());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <EpdFontData.h>
+#include <os/graphic/LruCache.h>
+
+#include <cstdint>
+
+// RAM cache of glyphs already thresholded to 1 bit (ink / no ink), keyed by (font data, glyph index).
+// Black/white rendering only needs "pixel != white", so a cached glyph skips decompression and 2-bit
+// decoding entirely, and takes a quarter of the space of its 2-bit bitmap. Masks are stored row-aligned:
+// rows of (width + 7) / 8 bytes, MSB first. Least recently used glyphs are evicted to stay within the
+// byte budget.
+class GlyphAtlas {
+ public:
+  static constexpr uint32_t DEFAULT_BUDGET = 16 * 1024;
+
+  using Stats = LruStats;
+
+  // Returns the cached mask and marks it most recently used, or nullptr
+  const uint8_t* find(const EpdFontData* fontData, uint32_t glyphIndex);
+  // Lookup without touching LRU order or statistics
+  bool contains(const EpdFontData* fontData, uint32_t glyphIndex) const;
+  // Threshold a glyph bitmap (as returned by FontDecompressor or stored in flash) and cache it. Returns the
+  // mask, or nullptr if the glyph does not fit in the budget or allocation failed.
+  const uint8_t* insert(const EpdFontData* fontData, uint32_t glyphIndex, const EpdGlyph* glyph,
+                        const uint8_t* bitmap);
+
+  void clear() { cache.clear(); }
+  // 0 disables the atlas
+  void setBudget(uint32_t bytes) { cache.setBudget(bytes); }
+  uint32_t getBudget() const { return cache.getBudget(); }
+
+  void logStats(const char* label = "ATLAS") const;
+  void resetStats() { cache.resetStats(); }
+  const Stats& getStats() const { return cache.getStats(); }
+
+ private:
+  static constexpr uint16_t BUCKET_COUNT = 256;
+
+  struct Entry : LruEntry<Entry> {
+    const EpdFontData* fontData;
+    uint32_t glyphIndex;
+    uint8_t* mask() { return reinterpret_cast<uint8_t*>(this + 1); }
+  };
+
+  LruCache<Entry, BUCKET_COUNT> cache{DEFAULT_BUDGET};
+
+  static uint32_t hashOf(const EpdFontData* fontData, uint32_t glyphIndex);
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+
+// Conversion of packed 1-bit and 2-bit glyph bitmaps into 1-bit coverage masks (1 = ink), shared by the
+// glyph blitters and the glyph atlas
+namespace glyphCoverage {
+
+// One glyph row as a 1-bit coverage mask, MSB first. EpdGlyph::width is 8 bits; the spare bytes absorb
+// the last 16-pixel chunk.
+constexpr int MAX_ROW_BYTES = 256 / 8 + 2;
+
+// Four bitmap bytes, big-endian, from byte i. Bytes past the end of the glyph read as zero, since the
+// bitmap may end right at the end of a buffer.
+inline uint32_t loadWord(const uint8_t* bitmap, uint32_t i, uint32_t size) {
+  if (i + 4 <= size) {
+    return static_cast<uint32_t>(bitmap[i]) << 24 | static_cast<uint32_t>(bitmap[i + 1]) << 16 |
+           static_cast<uint32_t>(bitmap[i + 2]) << 8 | bitmap[i + 3];
+  }
+  uint32_t w = 0;
+  for (uint32_t k = i; k < i + 4; k++) w = (w << 8) | (k < size ? bitmap[k] : 0);
+  return w;
+}
+
+// 16 pixels of a 2-bit bitmap starting at pixel q, MSB first
+inline uint32_t load2BitChunk(const uint8_t* bitmap, uint32_t bitmapBytes, uint32_t q) {
+  const uint32_t i = q >> 2;
+  const int shift = (q & 3) * 2;
+  uint32_t w = loadWord(bitmap, i, bitmapBytes);
+  if (shift) w = (w << shift) | (loadWord(bitmap, i + 4, bitmapBytes) >> (32 - shift));
+  return w;
+}
+
+// Pack the 16 even bits of w (one per 2-bit pixel, as left by masking with 0x55555555) into the low
+// half, pixel 0 landing in bit 15
+inline uint32_t packEvenBits(uint32_t w) {
+  w = (w | (w >> 1)) & 0x33333333;
+  w = (w | (w >> 2)) & 0x0F0F0F0F;
+  w = (w | (w >> 4)) & 0x00FF00FF;
+  return (w | (w >> 8)) & 0x0000FFFF;
+}
+
+inline void storeChunk(uint8_t* row, int c, uint32_t bits) {
+  row[c >> 3] = static_cast<uint8_t>(bits >> 8);
+  row[(c >> 3) + 1] = static_cast<uint8_t>(bits);
+}
+
+inline void clearTail(uint8_t* row, int n) {
+  if (n & 7) row[n >> 3] &= static_cast<uint8_t>(0xFF << (8 - (n & 7)));
+}
+
+// Convert the visible pixels [gx0, gx1) of glyph row gy into a coverage mask, 16 pixels per 32-bit word.
+// Glyph bitmaps are one continuous bit stream, so rows start at arbitrary bit offsets. Returns the
+// number of pixels converted; bits past it are cleared.
+template <bool Is2Bit>
+inline int extractRow(const uint8_t* bitmap, uint32_t bitmapBytes, int glyphWidth, int gx0, int gx1, int gy,
+                      uint8_t* cov) {
+  const int n = gx1 - gx0;
+  const uint32_t pos = static_cast<uint32_t>(gy) * glyphWidth + gx0;
+  for (int c = 0; c < n; c += 16) {
+    const uint32_t q = pos + c;
+    if constexpr (Is2Bit) {
+      // font: 0=white,1=light gray,2=dark gray,3=black; anything but white is inked
+      const uint32_t w = load2BitChunk(bitmap, bitmapBytes, q);
+      storeChunk(cov, c, packEvenBits((w | (w >> 1)) & 0x55555555));
+    } else {
+      // Any bit offset leaves at least 25 valid bits in the word
+      storeChunk(cov, c, (loadWord(bitmap, q >> 3, bitmapBytes) << (q & 7)) >> 16);
+    }
+  }
+  clearTail(cov, n);
+  return n;
+}
+
+// Like extractRow<true>(), also splitting out the gray levels in the encoding of the panel's grayscale
+// planes: lsb marks dark gray pixels, msb marks both gray levels. Solid black pixels are only in cov.
+inline int extractGrayRow(const uint8_t* bitmap, uint32_t bitmapBytes, int glyphWidth, int gx0, int gx1, int gy,
+                          uint8_t* cov, uint8_t* lsb, uint8_t* msb) {
+  const int n = gx1 - gx0;
+  const uint32_t pos = static_cast<uint32_t>(gy) * glyphWidth + gx0;
+  for (int c = 0; c < n; c += 16) {
+    const uint32_t w = load2BitChunk(bitmap, bitmapBytes, pos + c);
+    const uint32_t hi = (w >> 1) & 0x55555555;
+    const uint32_t lo = w & 0x55555555;
+    storeChunk(cov, c, packEvenBits(hi | lo));
+    storeChunk(lsb, c, packEvenBits(hi & ~lo));  // 2 = dark gray
+    storeChunk(msb, c, packEvenBits(hi ^ lo));   // 1 = light gray, 2 = dark gray
+  }
+  clearTail(cov, n);
+  clearTail(lsb, n);
+  clearTail(msb, n);
+  return n;
+}
+
+// Copy n bits of a row-aligned mask, starting at bit sx, to the start of cov, clearing bits past n
+inline void copyRow(const uint8_t* src, int sx, int n, uint8_t* cov) {
+  const uint8_t* s = src + (sx >> 3);
+  const int o = sx & 7;
+  const int nb = (n + 7) >> 3;
+  const int srcBytes = (o + n + 7) >> 3;
+  for (int j = 0; j < nb; j++) {
+    uint8_t v = static_cast<uint8_t>(s[j] << o);
+    if (o && j + 1 < srcBytes) v |= s[j + 1] >> (8 - o);
+    cov[j] = v;
+  }
+  if (n & 7) cov[nb - 1] &= static_cast<uint8_t>(0xFF << (8 - (n & 7)));
+}
+
+}  // namespace glyphCoverage
@@ -1,16 +1,33 @@
 #include "Graphic.h"
 
+#include <os/graphic/Canvas.h>
+#include <os/graphic/GlyphCoverage.h>
+#include <os/graphic/ImageDecoder.h>
 #include <os/internal.h>
 #include <os/hw/Display.h>
 #include <EpdFontData.h>
 #include <Utf8.h>
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
 Graphic& Graphic::getInstance() {
   static Graphic instance(Display::getInstance());
   return instance;
 }
 
-void Graphic::setOrientation(Orientation o) { orientation = o; }
+Graphic::~Graphic() {
+  free(backBuffer);
+  free(grayLsb);
+  free(grayMsb);
+}
+
+void Graphic::setOrientation(Orientation o) {
+  if (o != orientation) invalidateFrame();
+  orientation = o;
+}
 Graphic::Orientation Graphic::getOrientation() const { return orientation; }
 
 // Translate logical (x,y) to physical panel coordinates — mirrors GfxRenderer::rotateCoordinates
@@ -37,7 +54,7 @@ static inline void rotateCoordinates(Graphic::Orientation orientation, int x, in
   }
 }
 
-int Graphic::getWidth() const {
+int Graphic::getScreenWidth() const {
   switch (orientation) {
     case Portrait:
     case PortraitInverted:          return display.getHeight();
@@ -47,7 +64,7 @@ int Graphic::getWidth() const {
   return display.getWidth();
 }
 
-int Graphic::getHeight() const {
+int Graphic::getScreenHeight() const {
   switch (orientation) {
     case Portrait:
     case PortraitInverted:          return display.getWidth();
@@ -57,16 +74,40 @@ int Graphic::getHeight() const {
   return display.getHeight();
 }
 
+int Graphic::getWidth() const { return target ? target->width : getScreenWidth(); }
+
+int Graphic::getHeight() const { return target ? target->height : getScreenHeight(); }
+
+Graphic::Surface Graphic::getScreenSurface() const {
+  if (renderMode == LogicalBackBuffer) {
+    // Laid out like the native panel orientation, but with logical dimensions
+    const uint16_t w = getScreenWidth();
+    return {backBuffer, w, static_cast<uint16_t>(getScreenHeight()), static_cast<uint16_t>((w + 7) / 8),
+            LandscapeCounterClockwise};
+  }
+  return {display.getFrameBuffer(), display.getWidth(), display.getHeight(), display.getWidthBytes(),
+          orientation};
+}
+
+Graphic::Surface Graphic::getSurface() const {
+  if (target) return {target->buffer, target->phyW, target->phyH, target->widthBytes, target->layout};
+  return getScreenSurface();
+}
+
 void Graphic::drawPixel(int x, int y, bool black) const {
-  if (x < 0 || x >= getWidth() || y < 0 || y >= getHeight()) return;
+  const ClipRect area = getVisibleArea();
+  if (x < area.x0 || x >= area.x1 || y < area.y0 || y >= area.y1) return;
 
+  markDamage(x, y, 1, 1);
+  clearGray(x, y, 1, 1);
+  const Surface s = getSurface();
   int phyX, phyY;
-  rotateCoordinates(orientation, x, y, &phyX, &phyY, display.getWidth(), display.getHeight());
+  rotateCoordinates(s.orientation, x, y, &phyX, &phyY, s.width, s.height);
 
-  const uint32_t byteIndex = static_cast<uint32_t>(phyY) * display.getWidthBytes() + (phyX / 8);
+  const uint32_t byteIndex = static_cast<uint32_t>(phyY) * s.widthBytes + (phyX / 8);
   const uint8_t bitPos = 7 - (phyX % 8);  // MSB first; 0 = black on E-Ink
 
-  uint8_t* fb = display.getFrameBuffer();
+  uint8_t* fb = s.buffer;
   if (black) {
     fb[byteIndex] &= ~(1 << bitPos);
   } else {
@@ -74,29 +115,568 @@ void Graphic::drawPixel(int x, int y, bool black) const {
   }
 }
 
+// Translate a logical rectangle to the physical rectangle it covers. Every orientation is a
+// rotation/flip, so the result is still an axis-aligned rectangle.
+static inline void rotateRect(Graphic::Orientation orientation, int x, int y, int w, int h,
+                              int* phyX, int* phyY, int* phyW, int* phyH,
+                              uint16_t panelW, uint16_t panelH) {
+  switch (orientation) {
+    case Graphic::Portrait:
+      *phyX = y;
+      *phyY = panelH - x - w;
+      *phyW = h;
+      *phyH = w;
+      break;
+    case Graphic::LandscapeClockwise:
+      *phyX = panelW - x - w;
+      *phyY = panelH - y - h;
+      *phyW = w;
+      *phyH = h;
+      break;
+    case Graphic::PortraitInverted:
+      *phyX = panelW - y - h;
+      *phyY = x;
+      *phyW = h;
+      *phyH = w;
+      break;
+    case Graphic::LandscapeCounterClockwise:
+      *phyX = x;
+      *phyY = y;
+      *phyW = w;
+      *phyH = h;
+      break;
+  }
+}
+
+// Fill physical rows [phyY, phyY + phyH) between bits [phyX, phyX + phyW). Only the two ragged
+// edge bytes of each row are masked, the aligned middle is written with memset.
+static void fillPhysicalRect(uint8_t* fb, uint16_t widthBytes, int phyX, int phyY, int phyW, int phyH,
+                             bool black) {
+  const int firstByte = phyX >> 3;
+  const int lastByte = (phyX + phyW - 1) >> 3;
+  // MSB first: bit 7 of a byte is its leftmost pixel
+  uint8_t headMask = 0xFF >> (phyX & 7);
+  const uint8_t tailMask = 0xFF << (7 - ((phyX + phyW - 1) & 7));
+  if (firstByte == lastByte) headMask &= tailMask;
+  const int midBytes = lastByte - firstByte - 1;
+  const uint8_t fill = black ? 0x00 : 0xFF;  // 0 = black on E-Ink
+
+  uint8_t* row = fb + static_cast<uint32_t>(phyY) * widthBytes + firstByte;
+  for (int r = 0; r < phyH; r++, row += widthBytes) {
+    if (black) {
+      row[0] &= ~headMask;
+    } else {
+      row[0] |= headMask;
+    }
+    if (firstByte == lastByte) continue;
+    if (midBytes > 0) memset(row + 1, fill, midBytes);
+    if (black) {
+      row[midBytes + 1] &= ~tailMask;
+    } else {
+      row[midBytes + 1] |= tailMask;
+    }
+  }
+}
+
+// XOR physical rows [phyY, phyY + phyH) between bits [phyX, phyX + phyW). The ragged edge bytes are
+// masked; the middle is inverted a 32-bit word at a time once the pointer is aligned.
+static void invertPhysicalRect(uint8_t* fb, uint16_t widthBytes, int phyX, int phyY, int phyW, int phyH) {
+  const int firstByte = phyX >> 3;
+  const int lastByte = (phyX + phyW - 1) >> 3;
+  uint8_t headMask = 0xFF >> (phyX & 7);
+  const uint8_t tailMask = 0xFF << (7 - ((phyX + phyW - 1) & 7));
+  if (firstByte == lastByte) headMask &= tailMask;
+  const int midBytes = lastByte - firstByte - 1;
+
+  uint8_t* row = fb + static_cast<uint32_t>(phyY) * widthBytes + firstByte;
+  for (int r = 0; r < phyH; r++, row += widthBytes) {
+    row[0] ^= headMask;
+    if (firstByte == lastByte) continue;
+    uint8_t* p = row + 1;
+    int n = midBytes;
+    for (; n > 0 && (reinterpret_cast<uintptr_t>(p) & 3); n--) *p++ ^= 0xFF;
+    for (; n >= 4; n -= 4, p += 4) {
+      uint32_t word;
+      memcpy(&word, p, sizeof(word));
+      word = ~word;
+      memcpy(p, &word, sizeof(word));
+    }
+    for (; n > 0; n--) *p++ ^= 0xFF;
+    row[midBytes + 1] ^= tailMask;
+  }
+}
+
+// Damage is tracked in panel coordinates regardless of the render mode, since that is what gets flushed
+void Graphic::markDamage(int x, int y, int w, int h) const {
+  if (target) return;  // off-screen, the panel is unaffected until the canvas is composited
+  int phyX, phyY, phyW, phyH;
+  rotateRect(orientation, x, y, w, h, &phyX, &phyY, &phyW, &phyH, display.getWidth(), display.getHeight());
+  damage.add(phyX, phyY, phyW, phyH, display.getWidth(), display.getHeight());
+}
+
+// Anything drawn over gray text on the screen leaves plain black/white pixels behind
+void Graphic::clearGray(int x, int y, int w, int h) const {
+  if (!grayLsb || target) return;
+  int phyX, phyY, phyW, phyH;
+  rotateRect(orientation, x, y, w, h, &phyX, &phyY, &phyW, &phyH, display.getWidth(), display.getHeight());
+  fillPhysicalRect(grayLsb, display.getWidthBytes(), phyX, phyY, phyW, phyH, true);
+  fillPhysicalRect(grayMsb, display.getWidthBytes(), phyX, phyY, phyW, phyH, true);
+}
+
+Graphic::ClipRect Graphic::getVisibleArea() const {
+  return {std::max(clip.x0, 0), std::max(clip.y0, 0), std::min(clip.x1, getWidth()),
+          std::min(clip.y1, getHeight())};
+}
+
+bool Graphic::pushClip(int x, int y, int w, int h) { return pushClipRect({x, y, x + w, y + h}); }
+
+bool Graphic::pushClipRect(const ClipRect& r) {
+  if (clipDepth == MAX_CLIP_DEPTH) {
+    LOG_ERR("GFX", "Clip stack overflow");
+    return false;
+  }
+  clipStack[clipDepth++] = clip;
+  // An empty intersection is kept as an empty rect so everything drawn under it is rejected
+  clip = {std::max(clip.x0, r.x0), std::max(clip.y0, r.y0), std::min(clip.x1, r.x1), std::min(clip.y1, r.y1)};
+  return true;
+}
+
+void Graphic::popClip() {
+  if (clipDepth == 0) {
+    LOG_ERR("GFX", "Clip stack underflow");
+    return;
+  }
+  clip = clipStack[--clipDepth];
+}
+
+// Intersect recorded bounds with the current clip; false if nothing is left
+bool Graphic::clipBounds(DisplayList::Bounds* bounds) const {
+  const ClipRect area = getVisibleArea();
+  bounds->x0 = std::max(bounds->x0, area.x0);
+  bounds->y0 = std::max(bounds->y0, area.y0);
+  bounds->x1 = std::min(bounds->x1, area.x1);
+  bounds->y1 = std::min(bounds->y1, area.y1);
+  return bounds->x0 < bounds->x1 && bounds->y0 < bounds->y1;
+}
+
+// Conservative whole-line test for text drawn at (x, y): its ink stays within one line height of the
+// nominal [y, y + advanceY) line box (stacked accents, descenders) and never starts more than a line
+// height left of x. Lets lines scrolled out of view skip UTF-8 decoding and glyph lookups entirely.
+bool Graphic::isLineClipped(const EpdFontData* fontData, int x, int y) const {
+  const ClipRect area = getVisibleArea();
+  const int slack = fontData->advanceY;
+  return y + 2 * slack <= area.y0 || y - slack >= area.y1 || x - slack >= area.x1 || area.x0 >= area.x1 ||
+         area.y0 >= area.y1;
+}
+
+void Graphic::fillRect(int x, int y, int w, int h, bool black) const {
+  // Clip to the visible area once instead of per pixel
+  const ClipRect area = getVisibleArea();
+  const int x0 = std::max(x, area.x0);
+  const int y0 = std::max(y, area.y0);
+  const int x1 = std::min(x + w, area.x1);
+  const int y1 = std::min(y + h, area.y1);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  markDamage(x0, y0, x1 - x0, y1 - y0);
+  fillSpan(x0, y0, x1 - x0, y1 - y0, black);
+}
+
+// fillRect() without damage tracking, for shapes that mark their bounds once up front
+void Graphic::fillSpan(int x, int y, int w, int h, bool black) const {
+  const ClipRect area = getVisibleArea();
+  const int x0 = std::max(x, area.x0);
+  const int y0 = std::max(y, area.y0);
+  const int x1 = std::min(x + w, area.x1);
+  const int y1 = std::min(y + h, area.y1);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  clearGray(x0, y0, x1 - x0, y1 - y0);
+  const Surface s = getSurface();
+  int phyX, phyY, phyW, phyH;
+  rotateRect(s.orientation, x0, y0, x1 - x0, y1 - y0, &phyX, &phyY, &phyW, &phyH, s.width, s.height);
+  fillPhysicalRect(s.buffer, s.widthBytes, phyX, phyY, phyW, phyH, black);
+}
+
 void Graphic::drawBox(int x, int y, int w, int h, BoxOpts opts) const {
+  if (isRecording()) {
+    // Borders thicker than the box spill outside of it, include them in the bounds
+    const auto& b = opts.border;
+    DisplayList::Bounds bounds =
+        opts.fill ? DisplayList::Bounds{x, y, x + w, y + h}
+                  : DisplayList::Bounds{std::min(x, x + w - b.right), std::min(y, y + h - b.bottom),
+                                        std::max(x + w, x + b.left), std::max(y + h, y + b.top)};
+    if (clipBounds(&bounds)) frameList.addBox(x, y, w, h, opts, bounds, {clip.x0, clip.y0, clip.x1, clip.y1});
+    return;
+  }
+
   if (opts.fill) {
-    for (int py = y; py < y + h; py++) {
-      for (int px = x; px < x + w; px++) {
-        drawPixel(px, py, opts.black);
+    fillRect(x, y, w, h, opts.black);
+    return;
+  }
+
+  const auto& b = opts.border;
+  fillRect(x, y, w, b.top, opts.black);                  // top
+  fillRect(x, y + h - b.bottom, w, b.bottom, opts.black); // bottom
+  // left and right, excluding corners already drawn
+  fillRect(x, y + b.top, b.left, h - b.top - b.bottom, opts.black);
+  fillRect(x + w - b.right, y + b.top, b.right, h - b.top - b.bottom, opts.black);
+}
+
+void Graphic::invertRect(int x, int y, int w, int h) const {
+  if (isRecording()) {
+    DisplayList::Bounds bounds = {x, y, x + w, y + h};
+    if (clipBounds(&bounds)) frameList.addInvert(x, y, w, h, bounds, {clip.x0, clip.y0, clip.x1, clip.y1});
+    return;
+  }
+
+  const ClipRect area = getVisibleArea();
+  const int x0 = std::max(x, area.x0);
+  const int y0 = std::max(y, area.y0);
+  const int x1 = std::min(x + w, area.x1);
+  const int y1 = std::min(y + h, area.y1);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  // Gray levels do not survive inversion, the area is left plain black/white
+  markDamage(x0, y0, x1 - x0, y1 - y0);
+  clearGray(x0, y0, x1 - x0, y1 - y0);
+  const Surface s = getSurface();
+  int phyX, phyY, phyW, phyH;
+  rotateRect(s.orientation, x0, y0, x1 - x0, y1 - y0, &phyX, &phyY, &phyW, &phyH, s.width, s.height);
+  invertPhysicalRect(s.buffer, s.widthBytes, phyX, phyY, phyW, phyH);
+}
+
+void Graphic::invertRects(const Rect* rects, size_t count) const {
+  for (size_t i = 0; i < count; i++) invertRect(rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+}
+
+static int isqrt(int v) {
+  if (v <= 0) return 0;
+  int r = static_cast<int>(sqrtf(static_cast<float>(v)));
+  while (r * r > v) r--;
+  while ((r + 1) * (r + 1) <= v) r++;
+  return r;
+}
+
+// Half the width of the run of pixels of a circle of radius r whose centers lie inside it, on the row
+// whose center is yc2 / 2 from the circle's center
+static int circleHalfWidth(int r, int yc2) {
+  const int v = 4 * r * r - yc2 * yc2;
+  return v > 0 ? (isqrt(v) + 1) / 2 : 0;
+}
+
+bool Graphic::recordShape(const DisplayList::ShapeRef& shape, int x, int y, int w, int h,
+                          DisplayList::Bounds bounds) const {
+  if (!isRecording()) return false;
+  if (clipBounds(&bounds)) frameList.addShape(shape, x, y, w, h, bounds, {clip.x0, clip.y0, clip.x1, clip.y1});
+  return true;
+}
+
+// Shapes mark their whole bounds as damaged once instead of once per span. Returns false when nothing
+// of [x0, x1) x [y0, y1) is visible.
+bool Graphic::markShapeDamage(int x0, int y0, int x1, int y1) const {
+  const ClipRect area = getVisibleArea();
+  x0 = std::max(x0, area.x0);
+  y0 = std::max(y0, area.y0);
+  x1 = std::min(x1, area.x1);
+  y1 = std::min(y1, area.y1);
+  if (x0 >= x1 || y0 >= y1) return false;
+  markDamage(x0, y0, x1 - x0, y1 - y0);
+  return true;
+}
+
+void Graphic::drawLine(int x0, int y0, int x1, int y1, ShapeOpts opts) const {
+  const int t = std::max<int>(opts.stroke, 1);
+  const int lo = t / 2;  // thickness is centered on the line, extra pixel below / right
+  const DisplayList::Bounds bounds = {std::min(x0, x1) - lo, std::min(y0, y1) - lo, std::max(x0, x1) - lo + t,
+                                      std::max(y0, y1) - lo + t};
+  if (recordShape({DisplayList::ShapeRef::Line, opts, 0, 0, 0}, x0, y0, x1, y1, bounds)) return;
+  if (!markShapeDamage(bounds.x0, bounds.y0, bounds.x1, bounds.y1)) return;
+
+  // Horizontal and vertical lines are a single span
+  if (y0 == y1 || x0 == x1) {
+    fillSpan(bounds.x0, bounds.y0, bounds.x1 - bounds.x0, bounds.y1 - bounds.y0, opts.black);
+    return;
+  }
+
+  // Bresenham, emitting each run of pixels that share a row (x-major) or a column (y-major) as one span
+  const int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  const int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  const bool xMajor = dx >= -dy;
+  const auto run = [&](int ax, int ay, int bx, int by) {
+    if (xMajor) {
+      fillSpan(std::min(ax, bx), ay - lo, std::abs(bx - ax) + 1, t, opts.black);
+    } else {
+      fillSpan(ax - lo, std::min(ay, by), t, std::abs(by - ay) + 1, opts.black);
+    }
+  };
+  int err = dx + dy;
+  int x = x0, y = y0, runX = x0, runY = y0;
+  while (x != x1 || y != y1) {
+    const int e2 = 2 * err;
+    int nx = x, ny = y;
+    if (e2 >= dy) {
+      err += dy;
+      nx += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      ny += sy;
+    }
+    if (xMajor ? ny != y : nx != x) {
+      run(runX, runY, x, y);
+      runX = nx;
+      runY = ny;
+    }
+    x = nx;
+    y = ny;
+  }
+  run(runX, runY, x, y);
+}
+
+void Graphic::drawRoundRect(int x, int y, int w, int h, int radius, ShapeOpts opts) const {
+  if (w <= 0 || h <= 0) return;
+  if (recordShape({DisplayList::ShapeRef::RoundRect, opts, static_cast<int16_t>(radius), 0, 0}, x, y, w, h,
+                  {x, y, x + w, y + h})) {
+    return;
+  }
+  if (!markShapeDamage(x, y, x + w, y + h)) return;
+
+  const int r = std::max(0, std::min({radius, w / 2, h / 2}));
+  const int t = std::max<int>(opts.stroke, 1);
+  // An outline as thick as the shape is half as wide or tall is a filled shape
+  const bool solid = opts.fill || 2 * t >= w || 2 * t >= h;
+  // The outline is the outer shape minus the one inset by t, whose corners have radius r - t
+  const int ri = std::max(r - t, 0);
+  const int mid0 = std::max(r, t), mid1 = h - std::max(r, t);
+
+  // Straight middle section: one span, or the left and right edges
+  if (mid0 < mid1) {
+    if (solid) {
+      fillSpan(x, y + mid0, w, mid1 - mid0, opts.black);
+    } else {
+      fillSpan(x, y + mid0, t, mid1 - mid0, opts.black);
+      fillSpan(x + w - t, y + mid0, t, mid1 - mid0, opts.black);
+    }
+  }
+
+  // Rows of the top and bottom bands, which hold the corners and the horizontal edges
+  const ClipRect area = getVisibleArea();
+  for (int j = 0; j < h; j++) {
+    if (j == mid0 && mid0 < mid1) j = mid1;
+    if (y + j < area.y0 || y + j >= area.y1) continue;
+    const int edge = std::min(j, h - 1 - j);  // row counted from the nearest of top and bottom
+    const int a = edge < r ? r - circleHalfWidth(r, 2 * (r - edge) - 1) : 0;
+    if (solid || edge < t) {
+      fillSpan(x + a, y + j, w - 2 * a, 1, opts.black);
+      continue;
+    }
+    const int ie = edge - t;  // same for the inner shape
+    const int b = t + (ie < ri ? ri - circleHalfWidth(ri, 2 * (ri - ie) - 1) : 0);
+    fillSpan(x + a, y + j, b - a, 1, opts.black);
+    fillSpan(x + w - b, y + j, b - a, 1, opts.black);
+  }
+}
+
+void Graphic::drawCircle(int cx, int cy, int radius, ShapeOpts opts) const {
+  drawRoundRect(cx - radius, cy - radius, 2 * radius, 2 * radius, radius, opts);
+}
+
+void Graphic::drawArc(int cx, int cy, int radius, int startAngle, int endAngle, ShapeOpts opts) const {
+  if (radius <= 0) return;
+  if (recordShape({DisplayList::ShapeRef::Arc, opts, static_cast<int16_t>(radius), static_cast<int16_t>(startAngle),
+                   static_cast<int16_t>(endAngle)},
+                  cx, cy, 0, 0, {cx - radius, cy - radius, cx + radius, cy + radius})) {
+    return;
+  }
+  if (!markShapeDamage(cx - radius, cy - radius, cx + radius, cy + radius)) return;
+
+  const int sweep = endAngle - startAngle;
+  if (sweep <= 0) return;
+  const bool full = sweep >= 360;
+  const int start = ((startAngle % 360) + 360) % 360;
+  const int inner = opts.fill ? 0 : std::max(radius - std::max<int>(opts.stroke, 1), 0);
+
+  // The two edges of the sector, as rays from the center. They cut each row at most once each, so a
+  // row of the ring splits into at most a handful of pieces, each entirely inside or outside the sector.
+  constexpr float degToRad = 3.14159265f / 180.0f;
+  const float edgeCos[2] = {cosf(start * degToRad), cosf((start + sweep) * degToRad)};
+  const float edgeSin[2] = {sinf(start * degToRad), sinf((start + sweep) * degToRad)};
+  const auto inSector = [&](float px, float py) {
+    float a = atan2f(py, px) / degToRad - start;
+    while (a < 0) a += 360;
+    while (a >= 360) a -= 360;
+    return a <= sweep;
+  };
+  const auto fillPieces = [&](int k0, int k1, int j, float yc) {
+    int cuts[3] = {k0, k0, k0};
+    int n = 0;
+    for (int e = 0; e < 2; e++) {
+      if (edgeSin[e] == 0 || (yc > 0) != (edgeSin[e] > 0)) continue;
+      // Columns whose center lies left of the crossing belong to the left piece
+      const int cut = static_cast<int>(ceilf(yc * edgeCos[e] / edgeSin[e] - 0.5f));
+      if (cut > k0 && cut < k1) cuts[n++] = cut;
+    }
+    if (n == 2 && cuts[0] > cuts[1]) std::swap(cuts[0], cuts[1]);
+    int from = k0;
+    for (int i = 0; i <= n; i++) {
+      const int to = i < n ? cuts[i] : k1;
+      if (to > from && inSector((from + to) * 0.5f, yc)) fillSpan(cx + from, cy + j, to - from, 1, opts.black);
+      from = to;
+    }
+  };
+
+  const ClipRect area = getVisibleArea();
+  for (int j = -radius; j < radius; j++) {
+    if (cy + j < area.y0 || cy + j >= area.y1) continue;
+    const int yc2 = 2 * j + 1;  // twice the offset of the row's center from the circle's center
+    const int ho = circleHalfWidth(radius, yc2);
+    const int hi = circleHalfWidth(inner, yc2);
+    if (ho == 0) continue;
+    if (full) {
+      if (hi == 0) {
+        fillSpan(cx - ho, cy + j, 2 * ho, 1, opts.black);
+      } else {
+        fillSpan(cx - ho, cy + j, ho - hi, 1, opts.black);
+        fillSpan(cx + hi, cy + j, ho - hi, 1, opts.black);
       }
+      continue;
+    }
+    if (hi == 0) {
+      fillPieces(-ho, ho, j, yc2 * 0.5f);
+    } else {
+      fillPieces(-ho, -hi, j, yc2 * 0.5f);
+      fillPieces(hi, ho, j, yc2 * 0.5f);
     }
+  }
+}
+
+void Graphic::drawProgressBar(int x, int y, int w, int h, uint8_t percent, bool black) const {
+  drawRoundRect(x, y, w, h, h / 2, ShapeOpts{false, black, 1});
+  // Leave a one pixel gap between the outline and the bar
+  const int fillW = (w - 4) * std::min<int>(percent, 100) / 100;
+  if (fillW > 0 && h > 4) drawRoundRect(x + 2, y + 2, fillW, h - 4, (h - 4) / 2, ShapeOpts{true, black, 1});
+}
+
+bool Graphic::createCanvas(Canvas& canvas, int width, int height) const {
+  return canvas.allocate(width, height, getScreenSurface().orientation);
+}
+
+void Graphic::setTarget(Canvas* canvas) {
+  if (canvas && !canvas->valid()) {
+    LOG_ERR("GFX", "Render target canvas is not allocated");
     return;
   }
+  target = canvas;
+  if (target) target->version++;
+}
 
-  const auto& b = opts.border;
-  // top
-  for (int t = 0; t < b.top; t++)
-    for (int px = x; px < x + w; px++) drawPixel(px, y + t, opts.black);
-  // bottom
-  for (int t = 0; t < b.bottom; t++)
-    for (int px = x; px < x + w; px++) drawPixel(px, y + h - 1 - t, opts.black);
-  // left (excluding corners already drawn)
-  for (int py = y + b.top; py < y + h - b.bottom; py++)
-    for (int t = 0; t < b.left; t++) drawPixel(x + t, py, opts.black);
-  // right (excluding corners already drawn)
-  for (int py = y + b.top; py < y + h - b.bottom; py++)
-    for (int t = 0; t < b.right; t++) drawPixel(x + w - 1 - t, py, opts.black);
+static inline uint8_t reverseBits(uint8_t b) {
+  b = static_cast<uint8_t>((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+  b = static_cast<uint8_t>((b & 0xCC) >> 2 | (b & 0x33) << 2);
+  return static_cast<uint8_t>((b & 0xAA) >> 1 | (b & 0x55) << 1);
+}
+
+// Combine n physical bits of one source row, starting at bit sx, into a destination row starting at
+// bit dx, calling apply(dstByte, srcBits, mask) once per destination byte. Each destination byte is
+// assembled from a 16-bit window of the source, so any relative bit alignment is handled with a single
+// shift. With CopyAligned, equally aligned middle bytes are plain copies.
+template <bool CopyAligned, typename Apply>
+static inline void combineRow(const uint8_t* src, int sx, uint8_t* dst, int dx, int n, Apply apply) {
+  const int firstByte = dx >> 3;
+  const int lastByte = (dx + n - 1) >> 3;
+  const int srcBytes = (sx + n + 7) >> 3;
+
+  // Source bits lined up with bit 7 of destination byte k; out-of-row source bytes read as zero and
+  // are masked off
+  auto load = [&](int k) -> uint8_t {
+    const int bit = sx + (k << 3) - dx;
+    const int i = bit >> 3;  // arithmetic shift: -1 for the partial head byte
+    const int o = bit & 7;
+    const uint8_t hi = i >= 0 ? src[i] : 0;
+    const uint8_t lo = o && i + 1 < srcBytes ? src[i + 1] : 0;
+    return static_cast<uint8_t>(((hi << 8) | lo) >> (8 - o));
+  };
+
+  uint8_t headMask = 0xFF >> (dx & 7);
+  const uint8_t tailMask = 0xFF << (7 - ((dx + n - 1) & 7));
+  if (firstByte == lastByte) headMask &= tailMask;
+  apply(dst[firstByte], load(firstByte), headMask);
+  if (firstByte == lastByte) return;
+
+  // Middle bytes always have both source bytes inside the row
+  const int bit = sx + ((firstByte + 1) << 3) - dx;
+  const uint8_t* s = src + (bit >> 3);
+  const int o = bit & 7;
+  if (CopyAligned && o == 0) {
+    memcpy(dst + firstByte + 1, s, lastByte - firstByte - 1);
+  } else {
+    for (int k = firstByte + 1; k < lastByte; k++, s++) {
+      const uint8_t v = o ? static_cast<uint8_t>(((s[0] << 8) | s[1]) >> (8 - o)) : s[0];
+      apply(dst[k], v, 0xFF);
+    }
+  }
+  apply(dst[lastByte], load(lastByte), tailMask);
+}
+
+template <Composite Mode>
+static void compositeRow(const uint8_t* src, int sx, uint8_t* dst, int dx, int n) {
+  combineRow<Mode == Composite::Opaque>(src, sx, dst, dx, n, [](uint8_t& d, uint8_t v, uint8_t m) {
+    if constexpr (Mode == Composite::Opaque) {
+      d = (d & ~m) | (v & m);
+    } else if constexpr (Mode == Composite::TransparentWhite) {
+      d &= v | ~m;  // 0 = black on E-Ink
+    } else if constexpr (Mode == Composite::TransparentBlack) {
+      d |= v & m;
+    } else {
+      d ^= ~v & m;
+    }
+  });
+}
+
+void Graphic::drawCanvas(const Canvas& canvas, int x, int y, Composite mode) const {
+  if (!canvas.valid() || &canvas == target) return;
+  if (isRecording()) {
+    DisplayList::Bounds bounds = {x, y, x + canvas.width, y + canvas.height};
+    if (clipBounds(&bounds)) {
+      frameList.addCanvas(&canvas, canvas.version, x, y, canvas.width, canvas.height, mode, bounds,
+                          {clip.x0, clip.y0, clip.x1, clip.y1});
+    }
+    return;
+  }
+
+  const Surface s = getSurface();
+  if (canvas.layout != s.orientation) {
+    LOG_ERR("GFX", "Canvas layout does not match the render target");
+    return;
+  }
+
+  const ClipRect area = getVisibleArea();
+  const int x0 = std::max(x, area.x0);
+  const int y0 = std::max(y, area.y0);
+  const int x1 = std::min(x + canvas.width, area.x1);
+  const int y1 = std::min(y + canvas.height, area.y1);
+  if (x0 >= x1 || y0 >= y1) return;
+  markDamage(x0, y0, x1 - x0, y1 - y0);
+  clearGray(x0, y0, x1 - x0, y1 - y0);
+
+  // Both sides share the same orientation, so the visible part maps to two physical rectangles of equal
+  // size and compositing is a row-by-row translation
+  int dstX, dstY, phyW, phyH, srcX, srcY, srcW, srcH;
+  rotateRect(s.orientation, x0, y0, x1 - x0, y1 - y0, &dstX, &dstY, &phyW, &phyH, s.width, s.height);
+  rotateRect(s.orientation, x0 - x, y0 - y, x1 - x0, y1 - y0, &srcX, &srcY, &srcW, &srcH, canvas.phyW,
+             canvas.phyH);
+
+  using RowFn = void (*)(const uint8_t*, int, uint8_t*, int, int);
+  const RowFn row = mode == Composite::Opaque             ? compositeRow<Composite::Opaque>
+                    : mode == Composite::TransparentWhite ? compositeRow<Composite::TransparentWhite>
+                    : mode == Composite::TransparentBlack ? compositeRow<Composite::TransparentBlack>
+                                                          : compositeRow<Composite::Xor>;
+  const uint8_t* src = canvas.buffer + static_cast<uint32_t>(srcY) * canvas.widthBytes;
+  uint8_t* dst = s.buffer + static_cast<uint32_t>(dstY) * s.widthBytes;
+  for (int r = 0; r < phyH; r++, src += canvas.widthBytes, dst += s.widthBytes) {
+    row(src, srcX, dst, dstX, phyW);
+  }
 }
 
 const uint8_t* Graphic::getGlyphBitmap(const EpdFontData* fontData, const EpdGlyph* glyph) const {
@@ -107,43 +687,197 @@ const uint8_t* Graphic::getGlyphBitmap(const EpdFontData* fontData, const EpdGly
   return &fontData->bitmap[glyph->dataOffset];
 }
 
-void Graphic::renderGlyph(const EpdFontFamily& font, uint32_t cp, int cursorX, int cursorY, bool black,
-                           EpdFontFamily::Style style) const {
-  const EpdGlyph* glyph = font.getGlyph(cp, style);
-  if (!glyph) return;
+// Everything the glyph blitter needs, resolved once per glyph. [gx0, gx1) x [gy0, gy1) is the part of
+// the glyph left after clipping against the screen.
+struct Graphic::GlyphBlit {
+  uint8_t* fb;
+  uint16_t widthBytes;
+  uint16_t panelW, panelH;
+  const uint8_t* bitmap;
+  uint32_t bitmapBytes;
+  int glyphWidth;
+  int rowBytes;      // Mask1Bit only
+  uint8_t* grayLsb;  // Gray2Bit only
+  uint8_t* grayMsb;
+  int originX, originY;  // logical position of glyph pixel (0, 0)
+  int gx0, gx1, gy0, gy1;
+  bool black;
+};
 
-  const EpdFontData* fontData = font.getData(style);
-  const uint8_t* bitmap = getGlyphBitmap(fontData, glyph);
-  if (!bitmap) return;
-
-  const int outerBase = cursorY - glyph->top;   // screenY = outerBase + glyphY
-  const int innerBase = cursorX + glyph->left;  // screenX = innerBase + glyphX
-
-  if (fontData->is2Bit) {
-    int pos = 0;
-    for (int gy = 0; gy < glyph->height; gy++) {
-      for (int gx = 0; gx < glyph->width; gx++, pos++) {
-        const uint8_t byte = bitmap[pos >> 2];
-        const uint8_t shift = static_cast<uint8_t>((3 - (pos & 3)) * 2);
-        // font: 0=white,1=light gray,2=dark gray,3=black → invert: 0=black,3=white
-        const uint8_t val = 3 - ((byte >> shift) & 0x3);
-        if (val < 3) drawPixel(innerBase + gx, outerBase + gy, black);
+// Write one glyph row, given as a 1-bit coverage mask of n pixels, into a panel-layout plane.
+// apply(dst, bits, mask) affects the bits set in both bits and mask. In landscape a row is a physical
+// row, so the mask is shifted into place and combined a byte at a time (bit-reversed for
+// LandscapeClockwise). In portrait a row is a physical column: the bit mask is fixed and each pixel is a
+// fixed row stride away, with empty mask bytes skipped whole.
+template <Graphic::Orientation O, typename Apply>
+void Graphic::writeGlyphRow(const GlyphBlit& b, uint8_t* plane, int gy, const uint8_t* cov, int n, Apply apply) {
+  const int nb = (n + 7) >> 3;
+  if constexpr (O == LandscapeCounterClockwise) {
+    // phyX = x, phyY = y
+    uint8_t* row = plane + static_cast<uint32_t>(b.originY + gy) * b.widthBytes;
+    combineRow<false>(cov, 0, row, b.originX + b.gx0, n, apply);
+  } else if constexpr (O == LandscapeClockwise) {
+    // phyX = panelW - 1 - x, phyY = panelH - 1 - y: pixels run right to left, so reverse the mask.
+    // Pixel gx1 - 1 ends up at bit (8 * nb - n) of the reversed mask.
+    uint8_t rev[glyphCoverage::MAX_ROW_BYTES];
+    for (int j = 0; j < nb; j++) rev[j] = reverseBits(cov[nb - 1 - j]);
+    uint8_t* row = plane + static_cast<uint32_t>(b.panelH - 1 - b.originY - gy) * b.widthBytes;
+    combineRow<false>(rev, 8 * nb - n, row, b.panelW - b.originX - b.gx1, n, apply);
+  } else {
+    int phyX, phyY;
+    rotateCoordinates(O, b.originX + b.gx0, b.originY + gy, &phyX, &phyY, b.panelW, b.panelH);
+    uint8_t* p = plane + static_cast<uint32_t>(phyY) * b.widthBytes + (phyX >> 3);
+    const uint8_t mask = 0x80 >> (phyX & 7);  // MSB first
+    // Portrait: phyY = panelH - 1 - x; PortraitInverted: phyY = x
+    const int step = O == Portrait ? -static_cast<int>(b.widthBytes) : b.widthBytes;
+    for (int j = 0; j < nb; j++) {
+      const uint8_t v = cov[j];
+      if (!v) {
+        p += 8 * step;
+        continue;
+      }
+      for (uint8_t bit = 0x80; bit; bit >>= 1, p += step) {
+        if (v & bit) apply(*p, mask, 0xFF);
       }
     }
-  } else {
-    int pos = 0;
-    for (int gy = 0; gy < glyph->height; gy++) {
-      for (int gx = 0; gx < glyph->width; gx++, pos++) {
-        const uint8_t byte = bitmap[pos >> 3];
-        if ((byte >> (7 - (pos & 7))) & 1) drawPixel(innerBase + gx, outerBase + gy, black);
+  }
+}
+
+// Glyph blitter specialized per orientation and bitmap format. Each glyph row is first converted to a
+// 1-bit coverage mask (atlas masks already are one) and then written with writeGlyphRow(). Gray2Bit also
+// splits the row into gray level masks and updates both grayscale planes from the same decode.
+template <Graphic::Orientation O, Graphic::GlyphFormat F>
+void Graphic::blitGlyph(const GlyphBlit& b) {
+  uint8_t cov[glyphCoverage::MAX_ROW_BYTES];
+  const auto apply = [black = b.black](uint8_t& d, uint8_t v, uint8_t m) {
+    if (black) {
+      d &= ~(v & m);  // 0 = black on E-Ink
+    } else {
+      d |= v & m;
+    }
+  };
+  const auto clearBits = [](uint8_t& d, uint8_t v, uint8_t m) { d &= ~(v & m); };
+  const auto setBits = [](uint8_t& d, uint8_t v, uint8_t m) { d |= v & m; };
+
+  for (int gy = b.gy0; gy < b.gy1; gy++) {
+    const int n = b.gx1 - b.gx0;
+
+    if constexpr (F == Mask1Bit && O == LandscapeCounterClockwise) {
+      // The atlas row is used in place, combineRow() takes care of the clipped edges
+      uint8_t* row = b.fb + static_cast<uint32_t>(b.originY + gy) * b.widthBytes;
+      combineRow<false>(b.bitmap + gy * b.rowBytes, b.gx0, row, b.originX + b.gx0, n, apply);
+    } else if constexpr (F == Gray2Bit) {
+      // Every inked pixel is black in the black/white frame; gray pixels additionally get their level
+      // in the planes, solid black ones are cleared there
+      uint8_t lsb[glyphCoverage::MAX_ROW_BYTES], msb[glyphCoverage::MAX_ROW_BYTES];
+      glyphCoverage::extractGrayRow(b.bitmap, b.bitmapBytes, b.glyphWidth, b.gx0, b.gx1, gy, cov, lsb, msb);
+      writeGlyphRow<O>(b, b.fb, gy, cov, n, apply);
+      writeGlyphRow<O>(b, b.grayLsb, gy, cov, n, clearBits);
+      writeGlyphRow<O>(b, b.grayLsb, gy, lsb, n, setBits);
+      writeGlyphRow<O>(b, b.grayMsb, gy, cov, n, clearBits);
+      writeGlyphRow<O>(b, b.grayMsb, gy, msb, n, setBits);
+    } else {
+      if constexpr (F == Mask1Bit) {
+        glyphCoverage::copyRow(b.bitmap + gy * b.rowBytes, b.gx0, n, cov);
+      } else {
+        glyphCoverage::extractRow<F == Packed2Bit>(b.bitmap, b.bitmapBytes, b.glyphWidth, b.gx0, b.gx1, gy, cov);
       }
+      writeGlyphRow<O>(b, b.fb, gy, cov, n, apply);
     }
   }
 }
 
-void Graphic::drawText(const char* text, int x, int y, TextOpts opts) const {
-  if (!text || *text == '\0' || !opts.font) return;
+Graphic::GlyphBlitFn Graphic::selectGlyphBlitter(GlyphFormat format) const {
+  static constexpr GlyphBlitFn blitters[4][4] = {
+      {blitGlyph<Portrait, Packed1Bit>, blitGlyph<Portrait, Packed2Bit>, blitGlyph<Portrait, Mask1Bit>,
+       blitGlyph<Portrait, Gray2Bit>},
+      {blitGlyph<LandscapeClockwise, Packed1Bit>, blitGlyph<LandscapeClockwise, Packed2Bit>,
+       blitGlyph<LandscapeClockwise, Mask1Bit>, blitGlyph<LandscapeClockwise, Gray2Bit>},
+      {blitGlyph<PortraitInverted, Packed1Bit>, blitGlyph<PortraitInverted, Packed2Bit>,
+       blitGlyph<PortraitInverted, Mask1Bit>, blitGlyph<PortraitInverted, Gray2Bit>},
+      {blitGlyph<LandscapeCounterClockwise, Packed1Bit>, blitGlyph<LandscapeCounterClockwise, Packed2Bit>,
+       blitGlyph<LandscapeCounterClockwise, Mask1Bit>, blitGlyph<LandscapeCounterClockwise, Gray2Bit>},
+  };
+  return blitters[getSurface().orientation][format];
+}
 
+bool Graphic::usesGlyphAtlas(const EpdFontData* fontData, bool black) const {
+  return fontData->groups != nullptr && atlas.getBudget() > 0 && !selectGlyphBlitters(fontData, black).gray;
+}
+
+Graphic::GlyphBlitters Graphic::selectGlyphBlitters(const EpdFontData* fontData, bool black) const {
+  // Only black text on the screen has gray levels to show; white text and canvases stay black/white
+  const bool gray = grayLsb && fontData->is2Bit && black && !target;
+  return {selectGlyphBlitter(fontData->is2Bit ? Packed2Bit : Packed1Bit), selectGlyphBlitter(Mask1Bit),
+          gray ? selectGlyphBlitter(Gray2Bit) : nullptr};
+}
+
+// Resolve the bitmap of a glyph and the blitter that draws it into b; nullptr if the bitmap is unavailable
+Graphic::GlyphBlitFn Graphic::fetchGlyph(const EpdFontData* fontData, const EpdGlyph* glyph,
+                                         const GlyphBlitters& blitters, GlyphBlit* b) const {
+  b->bitmapBytes = glyph->dataLength;
+  b->glyphWidth = glyph->width;
+  if (blitters.gray) {
+    // Gray levels are needed, the 1-bit atlas cannot serve this glyph
+    b->bitmap = getGlyphBitmap(fontData, glyph);
+    b->grayLsb = grayLsb;
+    b->grayMsb = grayMsb;
+    return b->bitmap ? blitters.gray : nullptr;
+  }
+  if (fontData->groups != nullptr && atlas.getBudget() > 0) {
+    // Compressed glyphs go through the 1-bit atlas, so repeated glyphs skip decompression altogether
+    const uint32_t glyphIndex = static_cast<uint32_t>(glyph - fontData->glyph);
+    const uint8_t* mask = atlas.find(fontData, glyphIndex);
+    if (!mask) {
+      b->bitmap = decompressor.getBitmap(fontData, glyph, glyphIndex);
+      if (!b->bitmap) return nullptr;
+      mask = atlas.insert(fontData, glyphIndex, glyph, b->bitmap);
+    }
+    if (mask) {
+      b->bitmap = mask;
+      b->rowBytes = (glyph->width + 7) / 8;
+      return blitters.mask;
+    }
+    return blitters.packed;
+  }
+  b->bitmap = getGlyphBitmap(fontData, glyph);
+  return b->bitmap ? blitters.packed : nullptr;
+}
+
+void Graphic::renderGlyph(const EpdFontData* fontData, const EpdGlyph* glyph, int cursorX, int cursorY,
+                          bool black, const GlyphBlitters& blitters) const {
+  if (!glyph) return;
+
+  GlyphBlit b;
+  b.originX = cursorX + glyph->left;  // screenX = originX + glyphX
+  b.originY = cursorY - glyph->top;   // screenY = originY + glyphY
+
+  // Clip the glyph rectangle once; skip the bitmap fetch entirely when nothing is visible
+  const ClipRect area = getVisibleArea();
+  b.gx0 = std::max(0, area.x0 - b.originX);
+  b.gy0 = std::max(0, area.y0 - b.originY);
+  b.gx1 = std::min<int>(glyph->width, area.x1 - b.originX);
+  b.gy1 = std::min<int>(glyph->height, area.y1 - b.originY);
+  if (b.gx0 >= b.gx1 || b.gy0 >= b.gy1) return;
+
+  const GlyphBlitFn blit = fetchGlyph(fontData, glyph, blitters, &b);
+  if (!blit) return;
+  markDamage(b.originX + b.gx0, b.originY + b.gy0, b.gx1 - b.gx0, b.gy1 - b.gy0);
+
+  const Surface s = getSurface();
+  b.fb = s.buffer;
+  b.widthBytes = s.widthBytes;
+  b.panelW = s.width;
+  b.panelH = s.height;
+  b.black = black;
+  blit(b);
+}
+
+// Walk the glyph placements of a string, calling fn(fontData, glyph, cursorX, cursorY) for each glyph to
+// draw, fontData being the font of the family's fallback chain the glyph came from. Shared by drawing and by
+// bounds computation so both agree on where every glyph lands.
+template <typename Fn>
+void Graphic::layoutText(const char* text, int x, int y, const TextOpts& opts, Fn&& fn) const {
   const EpdFontData* fontData = opts.font->getData(opts.style);
   const int cursorY = y + fontData->ascender;
 
@@ -157,11 +891,12 @@ void Graphic::drawText(const char* text, int x, int y, TextOpts opts) const {
 
   while ((cp = utf8NextCodepoint(reinterpret_cast<const uint8_t**>(&text)))) {
     if (utf8IsCombiningMark(cp)) {
-      const EpdGlyph* g = opts.font->getGlyph(cp, opts.style);
+      const EpdFontFamily::ResolvedGlyph mark = opts.font->resolveGlyph(cp, opts.style);
+      const EpdGlyph* g = mark.glyph;
       if (!g) continue;
       const int raiseBy = combiningMark::raiseAboveBase(g->top, g->height, lastBaseTop);
       const int cx = combiningMark::centerOver(lastBaseX, lastBaseLeft, lastBaseWidth, g->left, g->width);
-      renderGlyph(*opts.font, cp, cx, cursorY - raiseBy, opts.black, opts.style);
+      fn(mark.font->data, g, cx, cursorY - raiseBy);
       continue;
     }
 
@@ -172,17 +907,425 @@ void Graphic::drawText(const char* text, int x, int y, TextOpts opts) const {
       lastBaseX += fp4::toPixel(prevAdvanceFP + kernFP);
     }
 
-    const EpdGlyph* glyph = opts.font->getGlyph(cp, opts.style);
+    const EpdFontFamily::ResolvedGlyph resolved = opts.font->resolveGlyph(cp, opts.style);
+    const EpdGlyph* glyph = resolved.glyph;
     lastBaseLeft = glyph ? glyph->left : 0;
     lastBaseWidth = glyph ? glyph->width : 0;
     lastBaseTop = glyph ? glyph->top : 0;
     prevAdvanceFP = glyph ? glyph->advanceX : 0;
 
-    renderGlyph(*opts.font, cp, lastBaseX, cursorY, opts.black, opts.style);
+    if (glyph) fn(resolved.font->data, glyph, lastBaseX, cursorY);
     prevCp = cp;
   }
 }
 
+void Graphic::drawText(const char* text, int x, int y, TextOpts opts) const {
+  if (!text || *text == '\0' || !opts.font) return;
+  const EpdFontData* fontData = opts.font->getData(opts.style);
+  if (isLineClipped(fontData, x, y)) return;
+
+  if (isRecording()) {
+    DisplayList::Bounds bounds;
+    if (getTextBounds(text, x, y, opts, &bounds) && clipBounds(&bounds)) {
+      frameList.addText(text, x, y, opts, bounds, {clip.x0, clip.y0, clip.x1, clip.y1});
+    }
+    return;
+  }
+
+  // Glyphs outside the clip are rejected individually in renderGlyph() before their bitmap is fetched
+  const GlyphBlitters blitters = selectGlyphBlitters(fontData, opts.black);
+  layoutText(text, x, y, opts, [&](const EpdFontData* glyphData, const EpdGlyph* glyph, int cursorX,
+                                   int cursorY) {
+    renderGlyph(glyphData, glyph, cursorX, cursorY, opts.black,
+                glyphData == fontData ? blitters : selectGlyphBlitters(glyphData, opts.black));
+  });
+}
+
+bool Graphic::shapeText(const char* text, TextOpts opts, ShapedRun* run) const {
+  run->clear();
+  if (!text || *text == '\0' || !opts.font || !run->allocate(text, opts)) return false;
+  layoutText(text, 0, 0, opts, [&](const EpdFontData* fontData, const EpdGlyph* glyph, int cursorX,
+                                   int cursorY) {
+    run->append(fontData, glyph, cursorX, cursorY);
+  });
+  return true;
+}
+
+void Graphic::drawShaped(const ShapedRun& run, int x, int y) const {
+  if (run.empty() || !run.getOpts().font) return;
+  const TextOpts& opts = run.getOpts();
+  if (isLineClipped(opts.font->getData(opts.style), x, y)) return;
+
+  if (isRecording()) {
+    const ShapedRun::Bounds& b = run.getBounds();
+    DisplayList::Bounds bounds = {x + b.x0, y + b.y0, x + b.x1, y + b.y1};
+    if (run.hasInk() && clipBounds(&bounds)) {
+      frameList.addText(run.getText(), x, y, opts, bounds, {clip.x0, clip.y0, clip.x1, clip.y1});
+    }
+    return;
+  }
+  renderShaped(run, x, y, opts.black);
+}
+
+// The run's color is ignored: cached runs are shared by every color the string is drawn in
+void Graphic::renderShaped(const ShapedRun& run, int x, int y, bool black) const {
+  const TextOpts& opts = run.getOpts();
+  const EpdFontData* fontData = opts.font->getData(opts.style);
+  const GlyphBlitters blitters = selectGlyphBlitters(fontData, black);
+  for (const ShapedRun::Glyph& g : run) {
+    renderGlyph(g.fontData, g.glyph, x + g.x, y + g.y, black,
+                g.fontData == fontData ? blitters : selectGlyphBlitters(g.fontData, black));
+  }
+}
+
+// Cached shaping of a string, shaping and caching it on a miss when insert is set. nullptr when the
+// cache is disabled or the string could not be cached.
+const ShapedRun* Graphic::findShaped(const char* text, const TextOpts& opts, bool insert) const {
+  if (shapeCache.getBudget() == 0) return nullptr;
+  const ShapedRun* cached = shapeCache.find(text, opts);
+  if (cached || !insert) return cached;
+  ShapedRun run;
+  if (!shapeText(text, opts, &run)) return nullptr;
+  return shapeCache.insert(std::move(run));
+}
+
+// Labels measured with getLabelWidth() are already shaped; draw those from their glyph placements
+void Graphic::drawLabelText(const char* text, int x, int y, const TextOpts& opts) const {
+  if (const ShapedRun* run = findShaped(text, opts, false)) {
+    renderShaped(*run, x, y, opts.black);
+    return;
+  }
+  drawText(text, x, y, opts);
+}
+
+void Graphic::drawLabel(const char* text, int x, int y, TextOpts opts) {
+  if (!text || *text == '\0' || !opts.font) return;
+  const EpdFontData* fontData = opts.font->getData(opts.style);
+  if (isLineClipped(fontData, x, y)) return;
+
+  if (isRecording()) {
+    DisplayList::Bounds bounds;
+    if (getTextBounds(text, x, y, opts, &bounds) && clipBounds(&bounds)) {
+      frameList.addText(text, x, y, opts, bounds, {clip.x0, clip.y0, clip.x1, clip.y1}, DisplayList::Op::Label);
+    }
+    return;
+  }
+
+  // Labels are black/white only
+  if (labelCache.getBudget() == 0 || (grayLsb && fontData->is2Bit && opts.black && !target)) {
+    drawLabelText(text, x, y, opts);
+    return;
+  }
+
+  const LabelCache::Key key = {opts.font, static_cast<uint8_t>(opts.style),
+                               static_cast<uint8_t>(getSurface().orientation), opts.black};
+  LabelCache::Label label;
+  if (!labelCache.find(text, key, &label)) {
+    DisplayList::Bounds b;
+    if (!getTextBounds(text, 0, 0, opts, &b)) return;  // nothing but blanks
+    Canvas* canvas = labelCache.insert(text, key, b.x1 - b.x0, b.y1 - b.y0, b.x0, b.y0);
+    if (!canvas) {
+      drawLabelText(text, x, y, opts);
+      return;
+    }
+
+    // Rasterize on the opposite color, unclipped, then composite only the text color
+    Canvas* const savedTarget = target;
+    const ClipRect savedClip = clip;
+    target = canvas;
+    clip = {INT_MIN, INT_MIN, INT_MAX, INT_MAX};
+    canvas->clear(!opts.black);
+    drawLabelText(text, -b.x0, -b.y0, opts);
+    target = savedTarget;
+    clip = savedClip;
+    label = {canvas, b.x0, b.y0};
+  }
+  drawCanvas(*label.canvas, x + label.dx, y + label.dy,
+             opts.black ? Composite::TransparentWhite : Composite::TransparentBlack);
+}
+
+void Graphic::drawRuns(const TextRun* runs, size_t count, const EpdFontFamily& font, bool black) const {
+  if (!runs || count == 0) return;
+
+  // Styles may share font data when the family lacks one, so prewarm per distinct font data. Recorded
+  // runs are only rasterized at endFrame(), one command at a time.
+  const EpdFontData* warmed[FontDecompressor::MAX_PAGE_SLOTS] = {};
+  uint8_t warmedCount = 0;
+  if (!isRecording()) {
+    for (size_t i = 0; i < count && warmedCount < FontDecompressor::MAX_PAGE_SLOTS; i++) {
+      const EpdFontData* fontData = font.getData(runs[i].style);
+      if (!fontData->groups) continue;
+      if (std::find(warmed, warmed + warmedCount, fontData) != warmed + warmedCount) continue;
+      warmed[warmedCount++] = fontData;
+      prewarmRuns(runs, count, font, fontData, black);
+    }
+  }
+
+  if (isRecording() || !drawRunsTiled(runs, count, font, black)) {
+    for (size_t i = 0; i < count; i++) {
+      drawText(runs[i].text, runs[i].x, runs[i].y, TextOpts{&font, black, runs[i].style});
+    }
+  }
+
+  // Page slots are single-use; release them so the next prewarm starts from an empty decompressor
+  if (warmedCount > 0) decompressor.clearCache();
+}
+
+// Prewarm the decompressor with every glyph of fontData the visible runs will fetch from it. Glyphs the
+// atlas already holds are left out, so redrawing a cached page decompresses nothing.
+void Graphic::prewarmRuns(const TextRun* runs, size_t count, const EpdFontFamily& font,
+                          const EpdFontData* fontData, bool black) const {
+  const bool skipCached = usesGlyphAtlas(fontData, black);
+
+  size_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    const TextRun& r = runs[i];
+    if (r.text && font.getData(r.style) == fontData && !isLineClipped(fontData, r.x, r.y)) total += strlen(r.text);
+  }
+  if (total == 0) return;
+
+  char* text = static_cast<char*>(malloc(total + 1));
+  if (!text) {
+    LOG_ERR("GFX", "Failed to allocate %u bytes to prewarm runs", static_cast<unsigned>(total + 1));
+    return;
+  }
+
+  size_t len = 0;
+  for (size_t i = 0; i < count; i++) {
+    const TextRun& r = runs[i];
+    if (!r.text || font.getData(r.style) != fontData || isLineClipped(fontData, r.x, r.y)) continue;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(r.text);
+    while (*p) {
+      const uint8_t* start = p;
+      const uint32_t cp = utf8NextCodepoint(&p);
+      if (cp == 0) break;
+      // Blank glyphs (spaces) never have their bitmap fetched, nor do glyphs of fallback fonts from here
+      const EpdFontFamily::ResolvedGlyph resolved = font.resolveGlyph(cp, r.style);
+      const EpdGlyph* glyph = resolved.glyph;
+      if (glyph && resolved.font->data != fontData) continue;
+      if (glyph && (glyph->width == 0 || glyph->height == 0)) continue;
+      if (glyph && skipCached && atlas.contains(fontData, static_cast<uint32_t>(glyph - fontData->glyph))) continue;
+      memcpy(text + len, start, p - start);
+      len += p - start;
+    }
+  }
+  text[len] = '\0';
+
+  if (len > 0) decompressor.prewarmCache(fontData, text);
+  free(text);
+}
+
+// Inverse of rotateRect(): the logical rectangle covering a physical one. Landscape orientations are their
+// own inverse; Portrait and PortraitInverted undo each other with the panel dimensions swapped.
+static inline void unrotateRect(Graphic::Orientation orientation, int phyX, int phyY, int phyW, int phyH,
+                                int* x, int* y, int* w, int* h, uint16_t panelW, uint16_t panelH) {
+  switch (orientation) {
+    case Graphic::Portrait:
+      rotateRect(Graphic::PortraitInverted, phyX, phyY, phyW, phyH, x, y, w, h, panelH, panelW);
+      break;
+    case Graphic::PortraitInverted:
+      rotateRect(Graphic::Portrait, phyX, phyY, phyW, phyH, x, y, w, h, panelH, panelW);
+      break;
+    default:
+      rotateRect(orientation, phyX, phyY, phyW, phyH, x, y, w, h, panelW, panelH);
+      break;
+  }
+}
+
+// One visible glyph of a tiled page: its origin and the logical rectangle [x0, x1) x [y0, y1) left of it
+// after clipping
+struct Graphic::GlyphPlacement {
+  const EpdGlyph* glyph;
+  int16_t originX, originY;
+  int16_t x0, y0, x1, y1;
+  const EpdFontData* fontData;
+};
+
+// Tiled drawRuns(). Returns false, having drawn nothing, when the page is too small to be worth binning,
+// needs the grayscale planes, or the bins cannot be allocated.
+bool Graphic::drawRunsTiled(const TextRun* runs, size_t count, const EpdFontFamily& font, bool black) const {
+  constexpr int TILE_BYTES = TILE_SIZE / 8;
+
+  // Every placement consumes at least one byte of text, so the text length bounds the placement count
+  size_t maxGlyphs = 0;
+  for (size_t i = 0; i < count; i++) {
+    const TextRun& r = runs[i];
+    const EpdFontData* fontData = font.getData(r.style);
+    if (!r.text || isLineClipped(fontData, r.x, r.y)) continue;
+    if (selectGlyphBlitters(fontData, black).gray) return false;
+    maxGlyphs += strlen(r.text);
+  }
+  if (maxGlyphs < TILED_MIN_GLYPHS || maxGlyphs > UINT16_MAX) return false;
+
+  const Surface s = getSurface();
+  const int tilesX = (s.width + TILE_SIZE - 1) / TILE_SIZE;
+  const int tilesY = (s.height + TILE_SIZE - 1) / TILE_SIZE;
+  const int tileCount = tilesX * tilesY;
+
+  GlyphPlacement* placements = static_cast<GlyphPlacement*>(malloc(maxGlyphs * sizeof(GlyphPlacement)));
+  uint32_t* binStart = static_cast<uint32_t*>(calloc(tileCount + 1, sizeof(uint32_t)));
+  if (!placements || !binStart) {
+    LOG_ERR("GFX", "Failed to allocate tile bins for %u glyphs", static_cast<unsigned>(maxGlyphs));
+    free(placements);
+    free(binStart);
+    return false;
+  }
+
+  // Lay the page out once, keeping the visible part of every glyph. Glyphs of a grayscale fallback font
+  // only show up here and send the whole page back to the untiled path.
+  const ClipRect area = getVisibleArea();
+  size_t placed = 0;
+  bool gray = false;
+  for (size_t i = 0; i < count; i++) {
+    const TextRun& r = runs[i];
+    const EpdFontData* runData = font.getData(r.style);
+    if (!r.text || isLineClipped(runData, r.x, r.y)) continue;
+    layoutText(r.text, r.x, r.y, TextOpts{&font, black, r.style}, [&](const EpdFontData* fontData,
+                                                                      const EpdGlyph* glyph, int cursorX,
+                                                                      int cursorY) {
+      if (fontData != runData && selectGlyphBlitters(fontData, black).gray) gray = true;
+      const int originX = cursorX + glyph->left;
+      const int originY = cursorY - glyph->top;
+      const int x0 = std::max(area.x0, originX);
+      const int y0 = std::max(area.y0, originY);
+      const int x1 = std::min(area.x1, originX + glyph->width);
+      const int y1 = std::min(area.y1, originY + glyph->height);
+      if (x0 >= x1 || y0 >= y1) return;
+      placements[placed++] = {glyph,
+                              static_cast<int16_t>(originX),
+                              static_cast<int16_t>(originY),
+                              static_cast<int16_t>(x0),
+                              static_cast<int16_t>(y0),
+                              static_cast<int16_t>(x1),
+                              static_cast<int16_t>(y1),
+                              fontData};
+    });
+  }
+  if (gray) {
+    free(placements);
+    free(binStart);
+    return false;
+  }
+
+  // Counting sort of the placements into the tiles they touch: count, prefix sum, then fill backwards so
+  // each bin keeps drawing order and binStart[t] ends up at the first entry of tile t
+  auto forEachTile = [&](const GlyphPlacement& p, auto&& fn) {
+    int phyX, phyY, phyW, phyH;
+    rotateRect(s.orientation, p.x0, p.y0, p.x1 - p.x0, p.y1 - p.y0, &phyX, &phyY, &phyW, &phyH, s.width,
+               s.height);
+    for (int ty = phyY / TILE_SIZE; ty <= (phyY + phyH - 1) / TILE_SIZE; ty++) {
+      for (int tx = phyX / TILE_SIZE; tx <= (phyX + phyW - 1) / TILE_SIZE; tx++) fn(ty * tilesX + tx);
+    }
+  };
+  for (size_t i = 0; i < placed; i++) forEachTile(placements[i], [&](int t) { binStart[t]++; });
+  for (int t = 1; t < tileCount; t++) binStart[t] += binStart[t - 1];
+  const uint32_t entryCount = tileCount > 0 ? binStart[tileCount - 1] : 0;
+  binStart[tileCount] = entryCount;
+
+  uint16_t* entries = static_cast<uint16_t*>(malloc(std::max<uint32_t>(entryCount, 1) * sizeof(uint16_t)));
+  if (!entries) {
+    LOG_ERR("GFX", "Failed to allocate %u tile entries", static_cast<unsigned>(entryCount));
+    free(placements);
+    free(binStart);
+    return false;
+  }
+  for (size_t i = placed; i-- > 0;) {
+    forEachTile(placements[i], [&](int t) { entries[--binStart[t]] = static_cast<uint16_t>(i); });
+  }
+
+  uint8_t tile[TILE_SIZE * TILE_BYTES];
+  const EpdFontData* blitData = nullptr;
+  GlyphBlitters blitters = {};
+  for (int t = 0; t < tileCount; t++) {
+    if (binStart[t] == binStart[t + 1]) continue;
+
+    const int tileX = (t % tilesX) * TILE_SIZE;
+    const int tileY = (t / tilesX) * TILE_SIZE;
+    const int rows = std::min(TILE_SIZE, s.height - tileY);
+    const int rowBytes = std::min(TILE_BYTES, s.widthBytes - tileX / 8);
+    uint8_t* const fbTile = s.buffer + static_cast<uint32_t>(tileY) * s.widthBytes + tileX / 8;
+    for (int y = 0; y < rows; y++) memcpy(tile + y * TILE_BYTES, fbTile + y * s.widthBytes, rowBytes);
+
+    int lx, ly, lw, lh;
+    unrotateRect(s.orientation, tileX, tileY, std::min(TILE_SIZE, s.width - tileX), rows, &lx, &ly, &lw, &lh,
+                 s.width, s.height);
+
+    for (uint32_t e = binStart[t]; e < binStart[t + 1]; e++) {
+      const GlyphPlacement& p = placements[entries[e]];
+      GlyphBlit b;
+      b.originX = p.originX;
+      b.originY = p.originY;
+      b.gx0 = std::max<int>(p.x0, lx) - p.originX;
+      b.gy0 = std::max<int>(p.y0, ly) - p.originY;
+      b.gx1 = std::min<int>(p.x1, lx + lw) - p.originX;
+      b.gy1 = std::min<int>(p.y1, ly + lh) - p.originY;
+      if (b.gx0 >= b.gx1 || b.gy0 >= b.gy1) continue;
+
+      if (p.fontData != blitData) {
+        blitData = p.fontData;
+        blitters = selectGlyphBlitters(blitData, black);
+      }
+      const GlyphBlitFn blit = fetchGlyph(p.fontData, p.glyph, blitters, &b);
+      if (!blit) continue;
+
+      // Address the tile as if it were the panel: shift whichever logical axis feeds each physical axis,
+      // or shrink the panel where the mapping counts back from its far edge
+      b.fb = tile;
+      b.widthBytes = TILE_BYTES;
+      b.panelW = s.width;
+      b.panelH = s.height;
+      switch (s.orientation) {
+        case Portrait:  // phyX = y, phyY = panelH - 1 - x
+          b.originY -= tileX;
+          b.panelH -= tileY;
+          break;
+        case LandscapeClockwise:  // phyX = panelW - 1 - x, phyY = panelH - 1 - y
+          b.panelW -= tileX;
+          b.panelH -= tileY;
+          break;
+        case PortraitInverted:  // phyX = panelW - 1 - y, phyY = x
+          b.panelW -= tileX;
+          b.originX -= tileY;
+          break;
+        case LandscapeCounterClockwise:  // phyX = x, phyY = y
+          b.originX -= tileX;
+          b.originY -= tileY;
+          break;
+      }
+      b.black = black;
+      blit(b);
+    }
+
+    for (int y = 0; y < rows; y++) memcpy(fbTile + y * s.widthBytes, tile + y * TILE_BYTES, rowBytes);
+  }
+
+  for (size_t i = 0; i < placed; i++) {
+    const GlyphPlacement& p = placements[i];
+    markDamage(p.x0, p.y0, p.x1 - p.x0, p.y1 - p.y0);
+  }
+
+  free(entries);
+  free(binStart);
+  free(placements);
+  return true;
+}
+
+// Exact ink bounds of a string as drawText() would place it, without touching any bitmap
+bool Graphic::getTextBounds(const char* text, int x, int y, const TextOpts& opts,
+                            DisplayList::Bounds* bounds) const {
+  int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+  layoutText(text, x, y, opts, [&](const EpdFontData*, const EpdGlyph* glyph, int cursorX, int cursorY) {
+    if (glyph->width == 0 || glyph->height == 0) return;
+    x0 = std::min(x0, cursorX + glyph->left);
+    y0 = std::min(y0, cursorY - glyph->top);
+    x1 = std::max(x1, cursorX + glyph->left + glyph->width);
+    y1 = std::max(y1, cursorY - glyph->top + glyph->height);
+  });
+  if (x0 >= x1 || y0 >= y1) return false;
+  *bounds = {x0, y0, x1, y1};
+  return true;
+}
+
 int Graphic::getTextWidth(const char* text, TextOpts opts) const {
   if (!text || !opts.font) return 0;
   int w = 0, h = 0;
@@ -190,6 +1333,349 @@ int Graphic::getTextWidth(const char* text, TextOpts opts) const {
   return w;
 }
 
+int Graphic::getLabelWidth(const char* text, TextOpts opts) const {
+  if (!text || !opts.font) return 0;
+  if (const ShapedRun* run = findShaped(text, opts, true)) return run->getWidth();
+  int w = 0, h = 0;
+  opts.font->getTextDimensions(text, &w, &h, opts.style);
+  return w;
+}
+
+bool Graphic::drawImage(const ImageSource& source, int x, int y, int w, int h, ImageFit fit) const {
+  if (isRecording()) {
+    LOG_ERR("GFX", "Images cannot be recorded, draw them into a canvas");
+    return false;
+  }
+  if (w <= 0 || h <= 0) return true;
+
+  ImageDecoder decoder;
+  if (!decoder.open(source)) return false;
+
+  int outW = w, outH = h;
+  if (fit != ImageFit::Stretch) {
+    // Contain scales by the smaller of w / srcW and h / srcH, Cover by the larger
+    const int64_t srcW = decoder.getWidth(), srcH = decoder.getHeight();
+    const bool widthBound = w * srcH <= h * srcW;
+    if (widthBound == (fit == ImageFit::Contain)) {
+      outH = static_cast<int>(std::max<int64_t>(1, (srcH * w + srcW / 2) / srcW));
+    } else {
+      outW = static_cast<int>(std::max<int64_t>(1, (srcW * h + srcH / 2) / srcH));
+    }
+  }
+  const int imgX = x + (w - outW) / 2;
+  const int imgY = y + (h - outH) / 2;
+
+  const ClipRect area = getVisibleArea();
+  const int x0 = std::max({x, imgX, area.x0});
+  const int y0 = std::max({y, imgY, area.y0});
+  const int x1 = std::min({x + w, imgX + outW, area.x1});
+  const int y1 = std::min({y + h, imgY + outH, area.y1});
+  if (x0 >= x1 || y0 >= y1) return true;
+
+  // Start from white and only draw the dithered ink. Marks the damage and clears the gray planes.
+  fillRect(x0, y0, x1 - x0, y1 - y0, false);
+
+  struct ImageRows {
+    GlyphBlit blit;
+    Orientation orientation;
+    int imgY;
+  };
+  const Surface s = getSurface();
+  ImageRows rows = {};
+  rows.blit.fb = s.buffer;
+  rows.blit.widthBytes = s.widthBytes;
+  rows.blit.panelW = s.width;
+  rows.blit.panelH = s.height;
+  rows.blit.originX = x0;
+  rows.orientation = s.orientation;
+  rows.imgY = imgY;
+
+  // Rows are written in chunks the glyph row writer can take, which handles every orientation
+  const auto writeRow = [](void* ctx, int row, const uint8_t* ink, int count) {
+    auto& r = *static_cast<ImageRows*>(ctx);
+    const auto setBlack = [](uint8_t& d, uint8_t v, uint8_t m) { d &= ~(v & m); };
+    constexpr int chunk = (glyphCoverage::MAX_ROW_BYTES - 2) * 8;
+    uint8_t cov[glyphCoverage::MAX_ROW_BYTES];
+    GlyphBlit b = r.blit;
+    b.originY = r.imgY + row;
+    for (int c = 0; c < count; c += chunk) {
+      const int n = std::min(chunk, count - c);
+      glyphCoverage::copyRow(ink, c, n, cov);
+      b.gx0 = c;
+      b.gx1 = c + n;
+      switch (r.orientation) {
+        case Portrait:
+          writeGlyphRow<Portrait>(b, b.fb, 0, cov, n, setBlack);
+          break;
+        case LandscapeClockwise:
+          writeGlyphRow<LandscapeClockwise>(b, b.fb, 0, cov, n, setBlack);
+          break;
+        case PortraitInverted:
+          writeGlyphRow<PortraitInverted>(b, b.fb, 0, cov, n, setBlack);
+          break;
+        case LandscapeCounterClockwise:
+          writeGlyphRow<LandscapeCounterClockwise>(b, b.fb, 0, cov, n, setBlack);
+          break;
+      }
+    }
+  };
+  return decoder.decode(outW, outH, {x0 - imgX, y0 - imgY, x1 - imgX, y1 - imgY}, writeRow, &rows);
+}
+
 int Graphic::getLineHeight(const EpdFontFamily& font) const { return font.getData()->advanceY; }
 
 int Graphic::getAscender(const EpdFontFamily& font) const { return font.getData()->ascender; }
+
+bool Graphic::setRenderMode(RenderMode mode) {
+  if (mode == renderMode) return true;
+
+  if (mode == LogicalBackBuffer) {
+    if (grayLsb) {
+      LOG_ERR("GFX", "Logical back buffer is not available with grayscale text");
+      return false;
+    }
+    // Large enough for both portrait and landscape logical layouts
+    const uint32_t portraitBytes = static_cast<uint32_t>((display.getHeight() + 7) / 8) * display.getWidth();
+    const uint32_t landscapeBytes = static_cast<uint32_t>(display.getWidthBytes()) * display.getHeight();
+    backBuffer = static_cast<uint8_t*>(malloc(std::max(portraitBytes, landscapeBytes)));
+    if (!backBuffer) {
+      LOG_ERR("GFX", "Failed to allocate logical back buffer");
+      return false;
+    }
+    // Starts out white; callers are expected to redraw the whole screen after switching
+    memset(backBuffer, 0xFF, std::max(portraitBytes, landscapeBytes));
+  } else {
+    free(backBuffer);
+    backBuffer = nullptr;
+  }
+  renderMode = mode;
+  return true;
+}
+
+Graphic::RenderMode Graphic::getRenderMode() const { return renderMode; }
+
+// Transpose an 8x8 bit block (Hacker's Delight, transpose8rS32). Row r of src becomes column r of dst,
+// MSB first on both sides. Strides may be negative to flip the block while transposing.
+static inline void transpose8x8(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride) {
+  uint32_t x = (src[0] << 24) | (src[srcStride] << 16) | (src[2 * srcStride] << 8) | src[3 * srcStride];
+  uint32_t y = (src[4 * srcStride] << 24) | (src[5 * srcStride] << 16) | (src[6 * srcStride] << 8) |
+               src[7 * srcStride];
+  uint32_t t;
+
+  t = (x ^ (x >> 7)) & 0x00AA00AA;
+  x = x ^ t ^ (t << 7);
+  t = (y ^ (y >> 7)) & 0x00AA00AA;
+  y = y ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC;
+  x = x ^ t ^ (t << 14);
+  t = (y ^ (y >> 14)) & 0x0000CCCC;
+  y = y ^ t ^ (t << 14);
+  t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+  y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+  x = t;
+
+  dst[0] = x >> 24;
+  dst[dstStride] = x >> 16;
+  dst[2 * dstStride] = x >> 8;
+  dst[3 * dstStride] = x;
+  dst[4 * dstStride] = y >> 24;
+  dst[5 * dstStride] = y >> 16;
+  dst[6 * dstStride] = y >> 8;
+  dst[7 * dstStride] = y;
+}
+
+void Graphic::resolveBackBuffer() const {
+  if (renderMode != LogicalBackBuffer) return;
+
+  const Surface src = getScreenSurface();
+  uint8_t* fb = display.getFrameBuffer();
+  const int panelW = display.getWidth();
+  const int panelH = display.getHeight();
+  const int fbStride = display.getWidthBytes();
+  const int srcStride = src.widthBytes;
+
+  switch (orientation) {
+    case Portrait:
+      // phyX = y, phyY = panelH - 1 - x: logical rows 8k..8k+7 at byte column j become physical
+      // byte k of rows panelH - 1 - 8j .. panelH - 8 - 8j
+      for (int k = 0; k < panelW / 8; k++) {
+        const uint8_t* srcRow = src.buffer + k * 8 * srcStride;
+        for (int j = 0; j < panelH / 8; j++) {
+          transpose8x8(srcRow + j, srcStride, fb + (panelH - 1 - 8 * j) * fbStride + k, -fbStride);
+        }
+      }
+      break;
+    case PortraitInverted:
+      // phyX = panelW - 1 - y, phyY = x: same as portrait with the source block flipped vertically
+      for (int k = 0; k < panelW / 8; k++) {
+        const uint8_t* srcRow = src.buffer + (panelW - 1 - 8 * k) * srcStride;
+        for (int j = 0; j < panelH / 8; j++) {
+          transpose8x8(srcRow + j, -srcStride, fb + 8 * j * fbStride + k, fbStride);
+        }
+      }
+      break;
+    case LandscapeClockwise:
+      // phyX = panelW - 1 - x, phyY = panelH - 1 - y: rotate 180° by reversing rows, bytes and bits
+      for (int y = 0; y < panelH; y++) {
+        const uint8_t* srcRow = src.buffer + y * srcStride;
+        uint8_t* dstRow = fb + (panelH - 1 - y) * fbStride;
+        for (int b = 0; b < fbStride; b++) dstRow[fbStride - 1 - b] = reverseBits(srcRow[b]);
+      }
+      break;
+    case LandscapeCounterClockwise:
+      memcpy(fb, src.buffer, static_cast<uint32_t>(fbStride) * panelH);
+      break;
+  }
+}
+
+bool Graphic::setGrayscaleText(bool enabled) {
+  if (enabled == isGrayscaleText()) return true;
+
+  if (enabled) {
+    if (renderMode != DirectRotated) {
+      LOG_ERR("GFX", "Grayscale text requires direct rendering");
+      return false;
+    }
+    const uint32_t size = static_cast<uint32_t>(display.getWidthBytes()) * display.getHeight();
+    grayLsb = static_cast<uint8_t*>(malloc(size));
+    grayMsb = static_cast<uint8_t*>(malloc(size));
+    if (!grayLsb || !grayMsb) {
+      LOG_ERR("GFX", "Failed to allocate grayscale planes");
+      free(grayLsb);
+      free(grayMsb);
+      grayLsb = grayMsb = nullptr;
+      return false;
+    }
+    // Nothing gray yet; text drawn before this point stays black/white until redrawn
+    memset(grayLsb, 0, size);
+    memset(grayMsb, 0, size);
+  } else {
+    free(grayLsb);
+    free(grayMsb);
+    grayLsb = grayMsb = nullptr;
+  }
+  return true;
+}
+
+void Graphic::displayGrayscale() const {
+  if (!grayLsb) return;
+  if (!display.displayGrayBuffer(grayLsb, grayMsb)) LOG_DBG("GFX", "Panel has no grayscale support");
+}
+
+void Graphic::clearGlyphCache() {
+  atlas.clear();
+  labelCache.clear();
+  shapeCache.clear();
+  decompressor.clearCache();
+}
+
+void Graphic::displayBuffer(Display::RefreshMode mode) const {
+  resolveBackBuffer();
+  display.displayBuffer(mode);
+  damage.clear();
+}
+
+void Graphic::displayDamage(Display::RefreshMode mode) const {
+  if (damage.empty()) return;
+  resolveBackBuffer();
+  display.displayRegions(damage.data(), damage.size(), mode);
+  damage.clear();
+}
+
+void Graphic::beginFrame() {
+  frameList.clear();
+  recording = true;
+}
+
+void Graphic::invalidateFrame() {
+  lastFrameList.clear();
+  lastFrameValid = false;
+}
+
+// Draw a recorded command under the clip that was in effect when it was recorded
+void Graphic::replay(const DisplayList::Command& cmd) {
+  if (!pushClipRect({cmd.clip.x0, cmd.clip.y0, cmd.clip.x1, cmd.clip.y1})) return;
+  switch (cmd.op) {
+    case DisplayList::Op::Box:
+      drawBox(cmd.x, cmd.y, cmd.w, cmd.h, cmd.boxOpts());
+      break;
+    case DisplayList::Op::Text:
+      drawText(cmd.text(), cmd.x, cmd.y, cmd.textOpts());
+      break;
+    case DisplayList::Op::Canvas: {
+      const DisplayList::CanvasRef ref = cmd.canvasRef();
+      drawCanvas(*ref.canvas, cmd.x, cmd.y, ref.mode);
+      break;
+    }
+    case DisplayList::Op::Label:
+      drawLabel(cmd.text(), cmd.x, cmd.y, cmd.textOpts());
+      break;
+    case DisplayList::Op::Invert:
+      invertRect(cmd.x, cmd.y, cmd.w, cmd.h);
+      break;
+    case DisplayList::Op::Shape: {
+      const DisplayList::ShapeRef ref = cmd.shapeRef();
+      switch (ref.kind) {
+        case DisplayList::ShapeRef::Line:
+          drawLine(cmd.x, cmd.y, cmd.w, cmd.h, ref.opts);
+          break;
+        case DisplayList::ShapeRef::RoundRect:
+          drawRoundRect(cmd.x, cmd.y, cmd.w, cmd.h, ref.radius, ref.opts);
+          break;
+        case DisplayList::ShapeRef::Arc:
+          drawArc(cmd.x, cmd.y, ref.radius, ref.startAngle, ref.endAngle, ref.opts);
+          break;
+      }
+      break;
+    }
+  }
+  popClip();
+}
+
+void Graphic::endFrame() {
+  recording = false;
+
+  if (!lastFrameValid) {
+    // First frame, or the first after invalidateFrame(): clear the screen and replay every command
+    fillRect(0, 0, getScreenWidth(), getScreenHeight(), false);
+    for (uint32_t i = 0; i < frameList.size(); i++) replay(frameList[i]);
+  } else {
+    // Match commands in order against the previous frame; whatever is left unmatched on either side
+    // has changed. Redraw regions are collected in logical coordinates.
+    DamageTracker redraw;
+    const uint16_t w = getScreenWidth();
+    const uint16_t h = getScreenHeight();
+    auto addRedraw = [&](const DisplayList::Command& c) {
+      redraw.add(c.bounds.x0, c.bounds.y0, c.bounds.x1 - c.bounds.x0, c.bounds.y1 - c.bounds.y0, w, h);
+    };
+
+    uint32_t next = 0;  // first previous-frame command not yet matched or skipped
+    for (uint32_t i = 0; i < frameList.size(); i++) {
+      const DisplayList::Command& cmd = frameList[i];
+      uint32_t j = next;
+      while (j < lastFrameList.size() && !cmd.equals(lastFrameList[j])) j++;
+      if (j == lastFrameList.size()) {
+        addRedraw(cmd);
+        continue;
+      }
+      for (; next < j; next++) addRedraw(lastFrameList[next]);  // dropped since last frame
+      next = j + 1;
+    }
+    for (; next < lastFrameList.size(); next++) addRedraw(lastFrameList[next]);
+
+    // Repaint each changed region from white with every command that touches it, clipped to it
+    for (uint8_t r = 0; r < redraw.size(); r++) {
+      const Display::Region& region = redraw.data()[r];
+      if (!pushClip(region.x, region.y, region.w, region.h)) break;
+      fillRect(region.x, region.y, region.w, region.h, false);
+      for (uint32_t i = 0; i < frameList.size(); i++) {
+        const DisplayList::Bounds& b = frameList[i].bounds;
+        if (b.x0 < clip.x1 && b.x1 > clip.x0 && b.y0 < clip.y1 && b.y1 > clip.y0) replay(frameList[i]);
+      }
+      popClip();
+    }
+  }
+
+  std::swap(frameList, lastFrameList);
+  lastFrameValid = true;
+}
@@ -2,24 +2,18 @@
 
 #include <EpdFontFamily.h>
 #include <FontDecompressor.h>
+#include <os/graphic/DamageTracker.h>
+#include <os/graphic/DisplayList.h>
+#include <os/graphic/DrawOpts.h>
+#include <os/graphic/GlyphAtlas.h>
+#include <os/graphic/LabelCache.h>
+#include <os/graphic/ShapeCache.h>
+#include <os/graphic/ShapedRun.h>
 #include <os/hw/Display.h>
 
-struct BoxOpts {
-  struct Border {
-    uint8_t top = 1, right = 1, bottom = 1, left = 1;
-    Border() = default;
-    explicit Border(uint8_t all) : top(all), right(all), bottom(all), left(all) {}
-  };
-  bool fill = false;
-  bool black = true;
-  Border border;
-};
+#include <climits>
 
-struct TextOpts {
-  const EpdFontFamily* font = nullptr;
-  bool black = true;
-  EpdFontFamily::Style style = EpdFontFamily::REGULAR;
-};
+class Canvas;
 
 class Graphic {
  public:
@@ -31,30 +25,217 @@ class Graphic {
     LandscapeCounterClockwise, // 800x480 logical, native panel orientation
   };
 
+  // Where rasterization happens. DirectRotated writes straight into the rotated panel framebuffer.
+  // LogicalBackBuffer draws into an extra plane laid out in logical orientation, so horizontal spans
+  // are contiguous bytes, and converts it to the panel layout in one pass on displayBuffer().
+  enum RenderMode {
+    DirectRotated,
+    LogicalBackBuffer,
+  };
+
   explicit Graphic(Display& display) : display(display) {}
-  ~Graphic() = default;
+  ~Graphic();
 
   static Graphic& getInstance();
 
   void setOrientation(Orientation o);
   Orientation getOrientation() const;
 
+  // Returns false if the back buffer could not be allocated; the render mode is left unchanged.
+  bool setRenderMode(RenderMode mode);
+  RenderMode getRenderMode() const;
+
+  // Size of the current render target: the screen, or the canvas passed to setTarget()
   int getWidth() const;
   int getHeight() const;
 
+  // Off-screen rendering. createCanvas() allocates a canvas in the layout of the screen, so it composites
+  // with plain byte copies. setTarget() redirects all drawing into the canvas (nullptr restores the screen);
+  // canvas drawing is never recorded or tracked as damage. drawCanvas() blits a canvas onto the current
+  // target at logical (x, y).
+  bool createCanvas(Canvas& canvas, int width, int height) const;
+  void setTarget(Canvas* canvas);
+  void drawCanvas(const Canvas& canvas, int x, int y, Composite mode = Composite::Opaque) const;
+
   void drawBox(int x, int y, int w, int h, BoxOpts opts = {}) const;
+  // Invert rectangles in place, e.g. to highlight a menu row or a text selection. Inverting the same
+  // rectangles again restores them, so moving a cursor is two small inverts followed by displayDamage().
+  // Where rectangles of one call overlap, the inversions cancel out.
+  void invertRect(int x, int y, int w, int h) const;
+  void invertRects(const Rect* rects, size_t count) const;
+
+  // Vector primitives, rasterized as runs of pixels written with the same byte-aligned fill as boxes.
+  // Angles are in degrees, clockwise from 3 o'clock; a sweep of 360 or more draws the whole ring. With
+  // opts.fill, arcs are pie slices.
+  void drawLine(int x0, int y0, int x1, int y1, ShapeOpts opts = {}) const;
+  void drawRoundRect(int x, int y, int w, int h, int radius, ShapeOpts opts = {}) const;
+  void drawCircle(int cx, int cy, int radius, ShapeOpts opts = {}) const;
+  void drawArc(int cx, int cy, int radius, int startAngle, int endAngle, ShapeOpts opts = {}) const;
+  // Pill-shaped outline, filled from the left up to percent (0-100)
+  void drawProgressBar(int x, int y, int w, int h, uint8_t percent, bool black = true) const;
   void drawText(const char* text, int x, int y, TextOpts opts) const;
+  // Draw mixed-style text, e.g. a paragraph with bold and italic words. The glyphs every style needs are
+  // decompressed up front, one prewarm per distinct font, instead of the styles taking turns evicting
+  // each other's group from the decompressor. Pages of at least TILED_MIN_GLYPHS glyphs are rasterized
+  // tile by tile: glyph placements are binned into TILE_SIZE square tiles of the panel, and each tile is
+  // composed in a stack buffer and written back with whole-byte stores, instead of every glyph doing its
+  // own read-modify-writes scattered over the framebuffer.
+  static constexpr int TILE_SIZE = 64;
+  static constexpr size_t TILED_MIN_GLYPHS = 256;
+  void drawRuns(const TextRun* runs, size_t count, const EpdFontFamily& font, bool black = true) const;
+  // drawText() through the label cache, for strings drawn over and over (menu entries, button hints,
+  // titles). The first draw rasterizes the string into a cached label; later draws with the same font,
+  // style and color are a single composite blit. Anti-aliased text bypasses the cache.
+  void drawLabel(const char* text, int x, int y, TextOpts opts);
   int getTextWidth(const char* text, TextOpts opts) const;
+  // getTextWidth() through the shape cache, for labels measured to lay them out and then drawn with
+  // drawLabel(): the string is shaped once for both. Bulk measurement such as pagination should use
+  // getTextWidth(), which leaves the cache alone.
+  int getLabelWidth(const char* text, TextOpts opts) const;
+  // Shape a string once to measure and draw it any number of times without repeating UTF-8 decoding,
+  // ligature, kerning and glyph lookups. Returns false for empty strings or when allocation failed.
+  bool shapeText(const char* text, TextOpts opts, ShapedRun* run) const;
+  void drawShaped(const ShapedRun& run, int x, int y) const;
+  // Decode a PNG or JPEG into (x, y, w, h), dithered to black and white. The image is streamed through
+  // the decoder a few rows at a time and written straight into the render target, so no decoded bitmap
+  // is ever held. Images are not recorded: in retained mode draw them into a canvas and draw that.
+  // Returns false if the image could not be opened or decoded.
+  bool drawImage(const ImageSource& source, int x, int y, int w, int h, ImageFit fit = ImageFit::Contain) const;
+
+  // Restrict drawing to the intersection of (x, y, w, h) with the current clip. Clips nest up to
+  // MAX_CLIP_DEPTH deep; pushClip() returns false (and changes nothing) when the stack is full.
+  // Every successful pushClip() must be balanced by a popClip().
+  static constexpr uint8_t MAX_CLIP_DEPTH = 8;
+  bool pushClip(int x, int y, int w, int h);
+  void popClip();
   int getLineHeight(const EpdFontFamily& font) const;
   int getAscender(const EpdFontFamily& font) const;
 
+  // Retained mode: between beginFrame() and endFrame() draw calls are only recorded. endFrame() diffs
+  // them against the previous frame and rasterizes just the regions where commands changed, starting
+  // from white, so unchanged content costs nothing. Follow it with displayDamage() to flush.
+  void beginFrame();
+  void endFrame();
+  // Forget the previous frame so the next endFrame() redraws everything (e.g. after drawing outside
+  // of a frame)
+  void invalidateFrame();
+
+  // Budgets of the 1-bit glyph atlas used for compressed fonts, of the label cache and of the shape cache,
+  // 0 disables them. clearGlyphCache() drops every cached glyph, label and shaped string; call it before
+  // freeing fonts that may have been drawn or measured.
+  void setGlyphAtlasBudget(uint32_t bytes) { atlas.setBudget(bytes); }
+  const GlyphAtlas& getGlyphAtlas() const { return atlas; }
+  void setLabelCacheBudget(uint32_t bytes) { labelCache.setBudget(bytes); }
+  const LabelCache& getLabelCache() const { return labelCache; }
+  void setShapeCacheBudget(uint32_t bytes) { shapeCache.setBudget(bytes); }
+  const ShapeCache& getShapeCache() const { return shapeCache; }
+  void clearGlyphCache();
+
+  // Anti-aliased text. While enabled, black text in 2-bit fonts also records its gray levels into two
+  // extra panel-sized planes, in the same glyph pass that draws it into the frame. displayGrayscale() then
+  // shows the levels over the frame last pushed with displayBuffer(). Requires DirectRotated rendering;
+  // returns false if the planes could not be allocated.
+  bool setGrayscaleText(bool enabled);
+  bool isGrayscaleText() const { return grayLsb != nullptr; }
+  void displayGrayscale() const;
+
+  // Push the frame to the panel, converting the logical back buffer first when it is in use
+  void displayBuffer(Display::RefreshMode mode = Display::FAST_REFRESH) const;
+  // Push only what was drawn since the last flush, see Display::displayRegions()
+  void displayDamage(Display::RefreshMode mode = Display::FAST_REFRESH) const;
+  const DamageTracker& getDamage() const { return damage; }
+
  private:
+  // How the glyph bitmap handed to a blitter is encoded
+  enum GlyphFormat : uint8_t {
+    Packed1Bit,  // font bitmap, one continuous bit stream
+    Packed2Bit,  // font bitmap, one continuous stream of 2-bit pixels
+    Mask1Bit,    // GlyphAtlas mask, rows padded to whole bytes
+    Gray2Bit,    // font bitmap, 2-bit, also written to the grayscale planes
+  };
+
+  struct GlyphBlit;
+  struct GlyphPlacement;
+  using GlyphBlitFn = void (*)(const GlyphBlit&);
+  // Blitters for one string, resolved once before its glyphs are walked
+  struct GlyphBlitters {
+    GlyphBlitFn packed;  // the font's own bitmap format
+    GlyphBlitFn mask;    // atlas hits
+    GlyphBlitFn gray;    // grayscale text, nullptr when it does not apply
+  };
+
+  // Logical rectangle [x0, x1) x [y0, y1) that drawing is restricted to
+  struct ClipRect {
+    int x0, y0, x1, y1;
+  };
+
+  // 1-bit plane being rasterized into, with the orientation used to address it
+  struct Surface {
+    uint8_t* buffer;
+    uint16_t width, height, widthBytes;  // physical geometry of the plane
+    Orientation orientation;
+  };
+
   Display& display;
   Orientation orientation = Portrait;
+  RenderMode renderMode = DirectRotated;
+  uint8_t* backBuffer = nullptr;
+  Canvas* target = nullptr;
+  uint8_t* grayLsb = nullptr;  // grayscale planes, panel layout, 1 = pixel takes part in the gray LUT
+  uint8_t* grayMsb = nullptr;
   mutable FontDecompressor decompressor;
+  mutable GlyphAtlas atlas;
+  LabelCache labelCache;
+  mutable ShapeCache shapeCache;
+  mutable DamageTracker damage;
+  ClipRect clip = {INT_MIN, INT_MIN, INT_MAX, INT_MAX};  // top of the clip stack
+  ClipRect clipStack[MAX_CLIP_DEPTH];                     // clips saved by pushClip()
+  uint8_t clipDepth = 0;
+
+  bool recording = false;
+  mutable DisplayList frameList;
+  DisplayList lastFrameList;
+  bool lastFrameValid = false;  // lastFrameList is what the screen shows
+
+  int getScreenWidth() const;
+  int getScreenHeight() const;
+  Surface getScreenSurface() const;
+  Surface getSurface() const;
+  bool isRecording() const { return recording && !target; }
+  void markDamage(int x, int y, int w, int h) const;
+  void clearGray(int x, int y, int w, int h) const;
+  bool pushClipRect(const ClipRect& r);
+  ClipRect getVisibleArea() const;
+  bool isLineClipped(const EpdFontData* fontData, int x, int y) const;
+  bool clipBounds(DisplayList::Bounds* bounds) const;
+  void replay(const DisplayList::Command& cmd);
+  bool getTextBounds(const char* text, int x, int y, const TextOpts& opts, DisplayList::Bounds* bounds) const;
+  template <typename Fn>
+  void layoutText(const char* text, int x, int y, const TextOpts& opts, Fn&& fn) const;
+  void resolveBackBuffer() const;
 
   void drawPixel(int x, int y, bool black) const;
+  void fillRect(int x, int y, int w, int h, bool black) const;
+  void fillSpan(int x, int y, int w, int h, bool black) const;
+  bool recordShape(const DisplayList::ShapeRef& shape, int x, int y, int w, int h,
+                   DisplayList::Bounds bounds) const;
+  bool markShapeDamage(int x0, int y0, int x1, int y1) const;
   const uint8_t* getGlyphBitmap(const EpdFontData* fontData, const EpdGlyph* glyph) const;
-  void renderGlyph(const EpdFontFamily& font, uint32_t cp, int cursorX, int cursorY, bool black,
-                   EpdFontFamily::Style style) const;
+  template <Orientation O, typename Apply>
+  static void writeGlyphRow(const GlyphBlit& b, uint8_t* plane, int gy, const uint8_t* cov, int n, Apply apply);
+  template <Orientation O, GlyphFormat F>
+  static void blitGlyph(const GlyphBlit& b);
+  GlyphBlitFn selectGlyphBlitter(GlyphFormat format) const;
+  GlyphBlitters selectGlyphBlitters(const EpdFontData* fontData, bool black) const;
+  GlyphBlitFn fetchGlyph(const EpdFontData* fontData, const EpdGlyph* glyph, const GlyphBlitters& blitters,
+                         GlyphBlit* b) const;
+  bool usesGlyphAtlas(const EpdFontData* fontData, bool black) const;
+  void prewarmRuns(const TextRun* runs, size_t count, const EpdFontFamily& font, const EpdFontData* fontData,
+                   bool black) const;
+  bool drawRunsTiled(const TextRun* runs, size_t count, const EpdFontFamily& font, bool black) const;
+  const ShapedRun* findShaped(const char* text, const TextOpts& opts, bool insert) const;
+  void renderShaped(const ShapedRun& run, int x, int y, bool black) const;
+  void drawLabelText(const char* text, int x, int y, const TextOpts& opts) const;
+  void renderGlyph(const EpdFontData* fontData, const EpdGlyph* glyph, int cursorX, int cursorY, bool black,
+                   const GlyphBlitters& blitters) const;
 };
@@ -0,0 +1,345 @@
+#include "ImageDecoder.h"
+
+#include <os/internal.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifndef SIMULATOR
+#include <HalStorage.h>
+#include <JPEGDEC.h>
+#include <PNGdec.h>
+#endif
+
+// Turns source rows, fed top to bottom, into dithered output rows. Output row o is made of source rows
+// [srcStart(o), srcEnd(o)), which partition the source when shrinking and repeat a row when enlarging.
+// Only the window's columns are ever resampled, so memory is bounded by what is visible.
+struct ImageDecoder::Pipeline {
+  int srcW = 0, srcH = 0;  // size of the rows fed in, after native JPEG scaling
+  int outW = 0, outH = 0;
+  Window window = {};
+  RowFn fn = nullptr;
+  void* ctx = nullptr;
+
+  uint32_t* sum = nullptr;  // per visible column, resampled source rows of the current output row
+  int16_t* err = nullptr;   // visible columns + 2, error carried to the next row, in 1/16 gray levels
+  uint8_t* ink = nullptr;
+  int summed = 0;  // source rows in sum
+  int nextSrc = 0;
+  int nextOut = 0;
+
+  uint8_t* gray = nullptr;    // PNG: current line
+  uint16_t* line = nullptr;   // PNG: current line as RGB565
+  uint8_t* strip = nullptr;   // JPEG: current MCU row
+  PNG* png = nullptr;
+
+  ~Pipeline() {
+    free(sum);
+    free(err);
+    free(ink);
+    free(gray);
+    free(line);
+    free(strip);
+  }
+
+  bool allocate(int width, int height) {
+    srcW = width;
+    srcH = height;
+    const int n = window.col1 - window.col0;
+    sum = static_cast<uint32_t*>(calloc(n, sizeof(uint32_t)));
+    err = static_cast<int16_t*>(calloc(n + 2, sizeof(int16_t)));
+    ink = static_cast<uint8_t*>(malloc((n + 7) / 8));
+    if (!sum || !err || !ink) {
+      LOG_ERR("IMG", "Failed to allocate dither rows for %d px", n);
+      return false;
+    }
+    return true;
+  }
+
+  // Every visible row has been emitted, the rest of the image can be skipped
+  bool finished() const { return nextOut >= window.row1; }
+
+  int srcStart(int o) const { return static_cast<int>(static_cast<int64_t>(o) * srcH / outH); }
+  int srcEnd(int o) const {
+    return std::max(srcStart(o) + 1, static_cast<int>(static_cast<int64_t>(o + 1) * srcH / outH));
+  }
+
+  // Feed the next source row of srcW gray pixels. Returns false once no more rows are needed.
+  bool push(const uint8_t* row) {
+    const int r = nextSrc++;
+    if (finished()) return false;
+
+    if (r >= srcStart(window.row0)) {
+      for (int c = window.col0; c < window.col1; c++) {
+        const int s0 = static_cast<int>(static_cast<int64_t>(c) * srcW / outW);
+        const int s1 = std::max(s0 + 1, static_cast<int>(static_cast<int64_t>(c + 1) * srcW / outW));
+        uint32_t v = 0;
+        for (int s = s0; s < s1; s++) v += row[s];
+        sum[c - window.col0] += v / (s1 - s0);
+      }
+      summed++;
+    }
+
+    while (nextOut < outH && srcEnd(nextOut) - 1 <= r) {
+      if (nextOut >= window.row0) emit(nextOut);
+      nextOut++;
+      if (finished()) return false;
+      // Enlarging: the next output row repeats this source row, keep the sums
+      if (srcStart(nextOut) <= r) continue;
+      memset(sum, 0, (window.col1 - window.col0) * sizeof(uint32_t));
+      summed = 0;
+      break;
+    }
+    return true;
+  }
+
+  // Floyd–Steinberg with a single error row: e[i] holds the error pushed down onto pixel i of this row
+  // until pixel i + 1 is done, then it is overwritten with the error for pixel i of the next row.
+  void emit(int o) {
+    const int n = window.col1 - window.col0;
+    memset(ink, 0, (n + 7) / 8);
+    int16_t* e = err + 1;
+    int right = 0;  // error pushed onto the next pixel of this row
+    int below = 0;  // next-row error for pixel i - 1, still missing pixel i's share
+    int next = 0;   // next-row error for pixel i
+    for (int i = 0; i < n; i++) {
+      const int v = static_cast<int>(sum[i] / summed) * 16 + e[i] + right;
+      const bool black = v < 128 * 16;
+      if (black) ink[i >> 3] |= 0x80 >> (i & 7);
+      const int q = (v - (black ? 0 : 255 * 16)) / 16;
+      right = 7 * q;
+      e[i - 1] = static_cast<int16_t>(below + 3 * q);
+      below = next + 5 * q;
+      next = q;
+    }
+    e[n - 1] = static_cast<int16_t>(below);
+    e[n] = static_cast<int16_t>(next);
+    fn(ctx, o, ink, n);
+  }
+};
+
+ImageDecoder::~ImageDecoder() { close(); }
+
+bool ImageDecoder::decode(int outW, int outH, const Window& window, RowFn fn, void* ctx) {
+  if (format == Format::None || outW <= 0 || outH <= 0) return false;
+  if (window.col0 < 0 || window.row0 < 0 || window.col1 > outW || window.row1 > outH ||
+      window.col0 >= window.col1 || window.row0 >= window.row1) {
+    return true;
+  }
+
+  Pipeline pipeline;
+  pipeline.outW = outW;
+  pipeline.outH = outH;
+  pipeline.window = window;
+  pipeline.fn = fn;
+  pipeline.ctx = ctx;
+  return format == Format::Png ? decodePng(pipeline) : decodeJpeg(pipeline, outW, outH);
+}
+
+#ifndef SIMULATOR
+
+namespace {
+
+void* openFile(const char* path, int32_t* size) {
+  auto* file = new (std::nothrow) HalFile();
+  if (!file) return nullptr;
+  if (!Storage.openFileForRead("IMG", path, *file)) {
+    delete file;
+    return nullptr;
+  }
+  *size = static_cast<int32_t>(file->size());
+  return file;
+}
+
+void closeFile(void* handle) {
+  auto* file = static_cast<HalFile*>(handle);
+  if (!file) return;
+  file->close();
+  delete file;
+}
+
+template <typename FileT>
+int32_t readFile(FileT* pFile, uint8_t* buf, int32_t len) {
+  return static_cast<HalFile*>(pFile->fHandle)->read(buf, len);
+}
+
+template <typename FileT>
+int32_t seekFile(FileT* pFile, int32_t pos) {
+  return static_cast<HalFile*>(pFile->fHandle)->seek(pos) ? pos : -1;
+}
+
+int drawPngLine(PNGDRAW* pDraw) {
+  auto& p = *static_cast<ImageDecoder::Pipeline*>(pDraw->pUser);
+  // Transparent pixels are blended onto white paper
+  p.png->getLineAsRGB565(pDraw, p.line, PNG_RGB565_LITTLE_ENDIAN, 0x00FFFFFF);
+  for (int i = 0; i < p.srcW; i++) {
+    const uint16_t c = p.line[i];
+    const uint32_t r = ((c >> 11) * 527 + 23) >> 6;
+    const uint32_t g = (((c >> 5) & 0x3F) * 259 + 33) >> 6;
+    const uint32_t b = ((c & 0x1F) * 527 + 23) >> 6;
+    p.gray[i] = static_cast<uint8_t>((r * 77 + g * 150 + b * 29) >> 8);
+  }
+  return p.push(p.gray) ? 1 : 0;
+}
+
+// Blocks of one MCU row arrive left to right and are collected in the strip until the row is complete
+int drawJpegBlock(JPEGDRAW* pDraw) {
+  auto& p = *static_cast<ImageDecoder::Pipeline*>(pDraw->pUser);
+  if (pDraw->x >= p.srcW) return 1;
+  const auto* pixels = reinterpret_cast<const uint8_t*>(pDraw->pPixels);
+  const int w = std::min(pDraw->iWidth, p.srcW - pDraw->x);
+  const int h = std::min(pDraw->iHeight, 16);
+  for (int r = 0; r < h; r++) {
+    memcpy(p.strip + r * p.srcW + pDraw->x, pixels + r * pDraw->iWidth, w);
+  }
+  if (pDraw->x + pDraw->iWidth < p.srcW) return 1;
+  for (int r = 0; r < h; r++) {
+    if (!p.push(p.strip + r * p.srcW)) return 0;
+  }
+  return 1;
+}
+
+}  // namespace
+
+bool ImageDecoder::open(const ImageSource& source) {
+  close();
+
+  uint8_t magic[4] = {};
+  if (source.data) {
+    if (source.size < sizeof(magic)) return false;
+    memcpy(magic, source.data, sizeof(magic));
+  } else if (source.path) {
+    HalFile file;
+    if (!Storage.openFileForRead("IMG", source.path, file)) return false;
+    const int n = file.read(magic, sizeof(magic));
+    file.close();
+    if (n != sizeof(magic)) return false;
+  } else {
+    return false;
+  }
+
+  auto* data = const_cast<uint8_t*>(source.data);
+  if (magic[0] == 0x89 && magic[1] == 'P' && magic[2] == 'N' && magic[3] == 'G') {
+    png = new (std::nothrow) PNG();
+    if (!png) {
+      LOG_ERR("IMG", "Failed to allocate PNG decoder");
+      return false;
+    }
+    const int rc = data ? png->openRAM(data, static_cast<int>(source.size), drawPngLine)
+                        : png->open(source.path, openFile, closeFile, readFile<PNGFILE>, seekFile<PNGFILE>,
+                                    drawPngLine);
+    if (rc != PNG_SUCCESS) {
+      LOG_ERR("IMG", "Cannot open PNG (%d)", png->getLastError());
+      close();
+      return false;
+    }
+    format = Format::Png;
+    width = png->getWidth();
+    height = png->getHeight();
+  } else if (magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF) {
+    jpeg = new (std::nothrow) JPEGDEC();
+    if (!jpeg) {
+      LOG_ERR("IMG", "Failed to allocate JPEG decoder");
+      return false;
+    }
+    const int rc = data ? jpeg->openRAM(data, static_cast<int>(source.size), drawJpegBlock)
+                        : jpeg->open(source.path, openFile, closeFile, readFile<JPEGFILE>, seekFile<JPEGFILE>,
+                                     drawJpegBlock);
+    if (!rc) {
+      LOG_ERR("IMG", "Cannot open JPEG (%d)", jpeg->getLastError());
+      close();
+      return false;
+    }
+    format = Format::Jpeg;
+    width = jpeg->getWidth();
+    height = jpeg->getHeight();
+  } else {
+    LOG_ERR("IMG", "Unknown image format");
+    return false;
+  }
+
+  if (width <= 0 || height <= 0) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void ImageDecoder::close() {
+  if (png) {
+    png->close();
+    delete png;
+    png = nullptr;
+  }
+  if (jpeg) {
+    jpeg->close();
+    delete jpeg;
+    jpeg = nullptr;
+  }
+  format = Format::None;
+  width = height = 0;
+}
+
+bool ImageDecoder::decodePng(Pipeline& pipeline) {
+  if (!pipeline.allocate(width, height)) return false;
+  pipeline.line = static_cast<uint16_t*>(malloc(width * sizeof(uint16_t)));
+  pipeline.gray = static_cast<uint8_t*>(malloc(width));
+  if (!pipeline.line || !pipeline.gray) {
+    LOG_ERR("IMG", "Failed to allocate PNG line for %d px", width);
+    return false;
+  }
+  pipeline.png = png;
+
+  const int rc = png->decode(&pipeline, 0);
+  // Aborting from the draw callback once the visible rows are done is reported as an error
+  if (rc != PNG_SUCCESS && !pipeline.finished()) {
+    LOG_ERR("IMG", "PNG decode failed (%d)", png->getLastError());
+    return false;
+  }
+  return true;
+}
+
+bool ImageDecoder::decodeJpeg(Pipeline& pipeline, int outW, int outH) {
+  // The decoder downscales for free while computing the IDCT, so use the largest reduction that still
+  // leaves at least one source pixel per output pixel
+  static constexpr int scaleOptions[] = {0, JPEG_SCALE_HALF, JPEG_SCALE_QUARTER, JPEG_SCALE_EIGHTH};
+  int shift = 0;
+  while (shift < 3 && (width >> (shift + 1)) >= outW && (height >> (shift + 1)) >= outH) shift++;
+
+  const int srcW = std::max(1, width >> shift);
+  if (!pipeline.allocate(srcW, std::max(1, height >> shift))) return false;
+  // MCUs are at most 16 rows tall
+  pipeline.strip = static_cast<uint8_t*>(malloc(srcW * 16));
+  if (!pipeline.strip) {
+    LOG_ERR("IMG", "Failed to allocate JPEG strip for %d px", srcW);
+    return false;
+  }
+
+  jpeg->setPixelType(EIGHT_BIT_GRAYSCALE);
+  jpeg->setUserPointer(&pipeline);
+  const int rc = jpeg->decode(0, 0, scaleOptions[shift]);
+  if (!rc && !pipeline.finished()) {
+    LOG_ERR("IMG", "JPEG decode failed (%d)", jpeg->getLastError());
+    return false;
+  }
+  return true;
+}
+
+#else
+
+bool ImageDecoder::open(const ImageSource& /*source*/) {
+  LOG_ERR("IMG", "Image decoding is not available in the simulator");
+  return false;
+}
+
+void ImageDecoder::close() {
+  format = Format::None;
+  width = height = 0;
+}
+
+bool ImageDecoder::decodePng(Pipeline& /*pipeline*/) { return false; }
+bool ImageDecoder::decodeJpeg(Pipeline& /*pipeline*/, int /*outW*/, int /*outH*/) { return false; }
+
+#endif  // SIMULATOR
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <os/graphic/DrawOpts.h>
+
+#include <cstdint>
+
+class PNG;
+class JPEGDEC;
+
+// Streams a PNG or JPEG into 1-bit rows at a requested size, never holding the whole decoded image.
+// JPEGs are decoded at the smallest native scale (1/2, 1/4, 1/8) that is still at least the requested size
+// and arrive one MCU row at a time; PNGs arrive one line at a time. Each source row is resampled (box
+// average when shrinking, nearest when enlarging) and the resulting gray rows are Floyd–Steinberg
+// dithered with a single row of error state.
+class ImageDecoder {
+ public:
+  // Receives output row `row` of the visible window as an ink mask of `count` pixels, MSB first,
+  // 1 = black. Bit 0 is column Window::col0.
+  using RowFn = void (*)(void* ctx, int row, const uint8_t* ink, int count);
+
+  // Part of the scaled image that is actually drawn, [col0, col1) x [row0, row1) in output pixels.
+  // Only these columns are resampled and dithered; rows outside still have to be decoded.
+  struct Window {
+    int col0, row0, col1, row1;
+  };
+
+  // Resampling and dithering state of one decode, shared with the decoder callbacks
+  struct Pipeline;
+
+  ImageDecoder() = default;
+  ~ImageDecoder();
+  ImageDecoder(const ImageDecoder&) = delete;
+  ImageDecoder& operator=(const ImageDecoder&) = delete;
+
+  // Reads the header only. Returns false for unknown formats or unreadable images.
+  bool open(const ImageSource& source);
+  void close();
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+
+  // Decode the open image scaled to outW x outH, once per open(). Returns false on decode or allocation
+  // failure; rows emitted before the failure stay drawn.
+  bool decode(int outW, int outH, const Window& window, RowFn fn, void* ctx);
+
+ private:
+  enum class Format : uint8_t { None, Png, Jpeg };
+
+  Format format = Format::None;
+  PNG* png = nullptr;
+  JPEGDEC* jpeg = nullptr;
+  int width = 0, height = 0;
+
+  bool decodePng(Pipeline& pipeline);
+  bool decodeJpeg(Pipeline& pipeline, int outW, int outH);
+};
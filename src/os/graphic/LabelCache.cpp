@@ -0,0 +1,81 @@
+#include "LabelCache.h"
+
+#include <os/graphic/Canvas.h>
+#include <os/internal.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+struct LabelCache::Entry : LruEntry<Entry> {
+  Key key;
+  uint16_t length;  // of the string, stored NUL-terminated right after the entry
+  int16_t dx, dy;
+  Canvas canvas;
+  char* text() { return reinterpret_cast<char*>(this + 1); }
+  const char* text() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+LabelCache::LabelCache() = default;
+LabelCache::~LabelCache() = default;
+
+uint32_t LabelCache::hashOf(const char* text, const Key& key, uint16_t* length) {
+  uint32_t h = fnv1a::string(fnv1a::OFFSET_BASIS, text, length);
+  h = fnv1a::mix(h, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(key.font)));
+  h = fnv1a::mix(h, key.style);
+  h = fnv1a::mix(h, key.layout);
+  return fnv1a::mix(h, key.black);
+}
+
+bool LabelCache::find(const char* text, const Key& key, Label* label) {
+  uint16_t length;
+  const uint32_t hash = hashOf(text, key, &length);
+  Entry* e = cache.find(hash, [&](const Entry& entry) {
+    return entry.length == length && entry.key.font == key.font && entry.key.style == key.style &&
+           entry.key.layout == key.layout && entry.key.black == key.black &&
+           memcmp(entry.text(), text, length) == 0;
+  });
+  if (!e) return false;
+  *label = {&e->canvas, e->dx, e->dy};
+  return true;
+}
+
+Canvas* LabelCache::insert(const char* text, const Key& key, int w, int h, int dx, int dy) {
+  uint16_t length;
+  const uint32_t hash = hashOf(text, key, &length);
+  const auto layout = static_cast<Graphic::Orientation>(key.layout);
+  const uint32_t size = sizeof(Entry) + length + 1 + Canvas::bufferSize(w, h, layout);
+  if (!cache.reserve(size)) return nullptr;
+
+  void* memory = malloc(sizeof(Entry) + length + 1);
+  if (!memory) {
+    LOG_ERR("LABELS", "Failed to allocate label entry");
+    return nullptr;
+  }
+  auto* e = new (memory) Entry;
+  if (!e->canvas.allocate(w, h, layout)) {
+    e->~Entry();
+    free(e);
+    return nullptr;
+  }
+  e->key = key;
+  e->length = length;
+  e->dx = static_cast<int16_t>(dx);
+  e->dy = static_cast<int16_t>(dy);
+  memcpy(e->text(), text, length + 1);
+
+  cache.add(e, hash, size);
+  return &e->canvas;
+}
+
+void LabelCache::clear() { cache.clear(); }
+
+void LabelCache::setBudget(uint32_t bytes) { cache.setBudget(bytes); }
+
+void LabelCache::logStats(const char* label) const {
+  const Stats& stats = cache.getStats();
+  const uint32_t total = stats.hits + stats.misses;
+  LOG_DBG("LABELS", "[%s] hits=%lu misses=%lu (%.1f%% hit rate) evictions=%lu", label, stats.hits, stats.misses,
+          total > 0 ? 100.0f * stats.hits / total : 0.0f, stats.evictions);
+  LOG_DBG("LABELS", "[%s] labels=%u bytes=%lu/%lu", label, stats.entries, stats.bytes, cache.getBudget());
+}
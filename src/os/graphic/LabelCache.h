@@ -0,0 +1,62 @@
+#pragma once
+
+#include <EpdFontFamily.h>
+#include <os/graphic/LruCache.h>
+
+#include <cstdint>
+
+class Canvas;
+
+// RAM cache of rasterized UI labels (menu entries, button hints, titles), keyed by the string and everything
+// else that changes how it rasterizes: font, style, color and canvas layout. Each label is a canvas covering
+// just the ink bounds of the string, so drawing a cached label is one composite blit with no UTF-8 decoding,
+// kerning or glyph lookups. Least recently used labels are evicted to stay within the byte budget.
+class LabelCache {
+ public:
+  static constexpr uint32_t DEFAULT_BUDGET = 8 * 1024;
+
+  using Stats = LruStats;
+
+  struct Key {
+    const EpdFontFamily* font;
+    uint8_t style;   // EpdFontFamily::Style
+    uint8_t layout;  // Graphic::Orientation of the canvas
+    bool black;
+  };
+
+  // A cached label: its canvas, whose top-left corner is (dx, dy) from the text origin
+  struct Label {
+    const Canvas* canvas;
+    int dx, dy;
+  };
+
+  // Defined where Entry is complete
+  LabelCache();
+  ~LabelCache();
+  LabelCache(const LabelCache&) = delete;
+  LabelCache& operator=(const LabelCache&) = delete;
+
+  // Looks the label up and marks it most recently used
+  bool find(const char* text, const Key& key, Label* label);
+  // Add an entry for a w x h label and return its cleared canvas for the caller to render into, or nullptr
+  // if it does not fit in the budget or allocation failed
+  Canvas* insert(const char* text, const Key& key, int w, int h, int dx, int dy);
+
+  void clear();
+  // 0 disables the cache
+  void setBudget(uint32_t bytes);
+  uint32_t getBudget() const { return cache.getBudget(); }
+
+  void logStats(const char* label = "LABELS") const;
+  void resetStats() { cache.resetStats(); }
+  const Stats& getStats() const { return cache.getStats(); }
+
+ private:
+  static constexpr uint16_t BUCKET_COUNT = 64;
+
+  struct Entry;
+
+  LruCache<Entry, BUCKET_COUNT> cache{DEFAULT_BUDGET};
+
+  static uint32_t hashOf(const char* text, const Key& key, uint16_t* length);
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// FNV-1a, the hash of the graphic caches' keys and of display list commands
+namespace fnv1a {
+constexpr uint32_t OFFSET_BASIS = 2166136261u;
+constexpr uint32_t PRIME = 16777619u;
+
+inline uint32_t mix(uint32_t h, uint32_t value) { return (h ^ value) * PRIME; }
+
+inline uint32_t bytes(uint32_t h, const void* data, size_t len) {
+  const auto* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) h = mix(h, p[i]);
+  return h;
+}
+
+// Hash of a NUL-terminated string, whose length is returned through length
+inline uint32_t string(uint32_t h, const char* text, uint16_t* length) {
+  const char* p = text;
+  for (; *p; p++) h = mix(h, static_cast<uint8_t>(*p));
+  *length = static_cast<uint16_t>(p - text);
+  return h;
+}
+}  // namespace fnv1a
+
+// Bookkeeping at the start of every LruCache entry: struct Entry : LruEntry<Entry> { ... }
+template <typename Entry>
+struct LruEntry {
+  uint32_t hash;
+  uint32_t size;  // bytes charged against the budget
+  Entry* chain;   // next entry in the same bucket
+  Entry* prev;    // towards most recently used
+  Entry* next;    // towards least recently used
+};
+
+struct LruStats {
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  uint32_t evictions = 0;
+  uint32_t bytes = 0;  // currently cached
+  uint16_t entries = 0;
+};
+
+// Hash table of heap entries kept in least recently used order within a byte budget; the storage behind
+// GlyphAtlas, LabelCache and ShapeCache. Entries are allocated with malloc() and constructed in place by
+// the owner, which computes their hash and size; the cache destroys and frees them on eviction.
+template <typename Entry, uint16_t BUCKET_COUNT>
+class LruCache {
+ public:
+  explicit LruCache(uint32_t budget) : budget(budget) {}
+  ~LruCache() { clear(); }
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  // First entry with this hash for which match(entry) holds, marked most recently used, or nullptr
+  template <typename Match>
+  Entry* find(uint32_t hash, Match&& match) {
+    Entry* e = peek(hash, match);
+    if (!e) {
+      stats.misses++;
+      return nullptr;
+    }
+    if (e != mru) {
+      unlink(e);
+      pushFront(e);
+    }
+    stats.hits++;
+    return e;
+  }
+
+  // Lookup without touching LRU order or statistics
+  template <typename Match>
+  Entry* peek(uint32_t hash, Match&& match) const {
+    for (Entry* e = buckets[hash % BUCKET_COUNT]; e; e = e->chain) {
+      if (e->hash == hash && match(*e)) return e;
+    }
+    return nullptr;
+  }
+
+  // Evict least recently used entries until size more bytes fit. False if size exceeds the whole budget.
+  bool reserve(uint32_t size) {
+    if (size > budget) return false;
+    while (stats.bytes + size > budget) {
+      evict(lru);
+      stats.evictions++;
+    }
+    return true;
+  }
+
+  // Take over a constructed entry of size bytes, reserve()d beforehand, as the most recently used
+  void add(Entry* e, uint32_t hash, uint32_t size) {
+    e->hash = hash;
+    e->size = size;
+    Entry*& bucket = buckets[hash % BUCKET_COUNT];
+    e->chain = bucket;
+    bucket = e;
+    pushFront(e);
+    stats.bytes += size;
+    stats.entries++;
+  }
+
+  void clear() {
+    while (lru) evict(lru);
+  }
+
+  void setBudget(uint32_t bytes) {
+    budget = bytes;
+    while (lru && stats.bytes > budget) {
+      evict(lru);
+      stats.evictions++;
+    }
+  }
+  uint32_t getBudget() const { return budget; }
+
+  const LruStats& getStats() const { return stats; }
+  void resetStats() {
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.evictions = 0;
+  }
+
+ private:
+  Entry* buckets[BUCKET_COUNT] = {};
+  Entry* mru = nullptr;
+  Entry* lru = nullptr;
+  uint32_t budget;
+  LruStats stats;
+
+  void unlink(Entry* e) {
+    (e->prev ? e->prev->next : mru) = e->next;
+    (e->next ? e->next->prev : lru) = e->prev;
+  }
+
+  void pushFront(Entry* e) {
+    e->prev = nullptr;
+    e->next = mru;
+    (mru ? mru->prev : lru) = e;
+    mru = e;
+  }
+
+  void evict(Entry* e) {
+    Entry** link = &buckets[e->hash % BUCKET_COUNT];
+    while (*link != e) link = &(*link)->chain;
+    *link = e->chain;
+    unlink(e);
+    stats.bytes -= e->size;
+    stats.entries--;
+    e->~Entry();
+    free(e);
+  }
+};
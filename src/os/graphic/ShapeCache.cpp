@@ -0,0 +1,60 @@
+#include "ShapeCache.h"
+
+#include <os/internal.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+struct ShapeCache::Entry : LruEntry<Entry> {
+  explicit Entry(ShapedRun&& run) : run(std::move(run)) {}
+  ShapedRun run;
+};
+
+ShapeCache::ShapeCache() = default;
+ShapeCache::~ShapeCache() = default;
+
+uint32_t ShapeCache::hashOf(const char* text, const TextOpts& opts, uint16_t* length) {
+  const uint32_t h = fnv1a::string(fnv1a::OFFSET_BASIS, text, length);
+  return fnv1a::mix(fnv1a::mix(h, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(opts.font))), opts.style);
+}
+
+const ShapedRun* ShapeCache::find(const char* text, const TextOpts& opts) {
+  uint16_t length;
+  const uint32_t hash = hashOf(text, opts, &length);
+  const Entry* e = cache.find(hash, [&](const Entry& entry) {
+    const TextOpts& o = entry.run.getOpts();
+    return entry.run.getLength() == length && o.font == opts.font && o.style == opts.style &&
+           memcmp(entry.run.getText(), text, length) == 0;
+  });
+  return e ? &e->run : nullptr;
+}
+
+const ShapedRun* ShapeCache::insert(ShapedRun&& run) {
+  uint16_t length;
+  const uint32_t hash = hashOf(run.getText(), run.getOpts(), &length);
+  const uint32_t size = sizeof(Entry) + run.byteSize();
+  if (!cache.reserve(size)) return nullptr;
+
+  void* memory = malloc(sizeof(Entry));
+  if (!memory) {
+    LOG_ERR("SHAPES", "Failed to allocate shape entry");
+    return nullptr;
+  }
+  auto* e = new (memory) Entry(std::move(run));
+  cache.add(e, hash, size);
+  return &e->run;
+}
+
+void ShapeCache::clear() { cache.clear(); }
+
+void ShapeCache::setBudget(uint32_t bytes) { cache.setBudget(bytes); }
+
+void ShapeCache::logStats(const char* label) const {
+  const Stats& stats = cache.getStats();
+  const uint32_t total = stats.hits + stats.misses;
+  LOG_DBG("SHAPES", "[%s] hits=%lu misses=%lu (%.1f%% hit rate) evictions=%lu", label, stats.hits, stats.misses,
+          total > 0 ? 100.0f * stats.hits / total : 0.0f, stats.evictions);
+  LOG_DBG("SHAPES", "[%s] runs=%u bytes=%lu/%lu", label, stats.entries, stats.bytes, cache.getBudget());
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <os/graphic/LruCache.h>
+#include <os/graphic/ShapedRun.h>
+
+#include <cstdint>
+
+// RAM cache of shaped strings keyed by the string, font and style. Graphic::getLabelWidth() shapes through it
+// and drawLabel() draws cached strings straight from their glyph placements, so the usual "measure, then
+// draw" of a UI string shapes it once. Least recently used runs are evicted to stay within the byte budget.
+class ShapeCache {
+ public:
+  static constexpr uint32_t DEFAULT_BUDGET = 4 * 1024;
+
+  using Stats = LruStats;
+
+  // Defined where Entry is complete
+  ShapeCache();
+  ~ShapeCache();
+  ShapeCache(const ShapeCache&) = delete;
+  ShapeCache& operator=(const ShapeCache&) = delete;
+
+  // Looks the run up and marks it most recently used, or nullptr
+  const ShapedRun* find(const char* text, const TextOpts& opts);
+  // Take over a shaped run; returns the cached run, or nullptr if it does not fit in the budget or
+  // allocation failed
+  const ShapedRun* insert(ShapedRun&& run);
+
+  void clear();
+  // 0 disables the cache
+  void setBudget(uint32_t bytes);
+  uint32_t getBudget() const { return cache.getBudget(); }
+
+  void logStats(const char* label = "SHAPES") const;
+  void resetStats() { cache.resetStats(); }
+  const Stats& getStats() const { return cache.getStats(); }
+
+ private:
+  static constexpr uint16_t BUCKET_COUNT = 32;
+
+  struct Entry;
+
+  LruCache<Entry, BUCKET_COUNT> cache{DEFAULT_BUDGET};
+
+  static uint32_t hashOf(const char* text, const TextOpts& opts, uint16_t* length);
+};
@@ -0,0 +1,77 @@
+#include "ShapedRun.h"
+
+#include <os/internal.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+ShapedRun::~ShapedRun() { clear(); }
+
+ShapedRun::ShapedRun(ShapedRun&& other) noexcept { *this = std::move(other); }
+
+ShapedRun& ShapedRun::operator=(ShapedRun&& other) noexcept {
+  if (this == &other) return *this;
+  free(glyphs);
+  glyphs = other.glyphs;
+  text = other.text;
+  count = other.count;
+  capacity = other.capacity;
+  length = other.length;
+  width = other.width;
+  widthX0 = other.widthX0;
+  widthX1 = other.widthX1;
+  bounds = other.bounds;
+  opts = other.opts;
+  other.glyphs = nullptr;
+  other.text = nullptr;
+  other.count = other.capacity = other.length = 0;
+  return *this;
+}
+
+void ShapedRun::clear() {
+  free(glyphs);
+  glyphs = nullptr;
+  text = nullptr;
+  count = capacity = length = 0;
+  width = widthX0 = widthX1 = 0;
+  bounds = {0, 0, 0, 0};
+}
+
+uint32_t ShapedRun::byteSize() const { return capacity * sizeof(Glyph) + length + 1; }
+
+// Every glyph consumes at least one byte of text, so the text length bounds the glyph count
+bool ShapedRun::allocate(const char* source, TextOpts textOpts) {
+  clear();
+  const size_t n = strlen(source);
+  if (n > UINT16_MAX) return false;
+  glyphs = static_cast<Glyph*>(malloc(n * sizeof(Glyph) + n + 1));
+  if (!glyphs) {
+    LOG_ERR("GFX", "Failed to allocate shaped run of %u bytes", static_cast<unsigned>(n));
+    return false;
+  }
+  text = reinterpret_cast<char*>(glyphs + n);
+  memcpy(text, source, n + 1);
+  capacity = length = static_cast<uint16_t>(n);
+  opts = textOpts;
+  bounds = {INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN};
+  return true;
+}
+
+void ShapedRun::append(const EpdFontData* fontData, const EpdGlyph* glyph, int x, int y) {
+  if (count == capacity) return;
+  glyphs[count++] = {fontData, glyph, static_cast<int16_t>(x), static_cast<int16_t>(y)};
+
+  // Measured like EpdFont::getTextDimensions(): every glyph box counts, starting from the origin
+  widthX0 = std::min<int>(widthX0, x + glyph->left);
+  widthX1 = std::max<int>(widthX1, x + glyph->left + glyph->width);
+  width = static_cast<int16_t>(widthX1 - widthX0);
+
+  if (glyph->width == 0 || glyph->height == 0) return;
+  bounds.x0 = std::min<int>(bounds.x0, x + glyph->left);
+  bounds.y0 = std::min<int>(bounds.y0, y - glyph->top);
+  bounds.x1 = std::max<int>(bounds.x1, x + glyph->left + glyph->width);
+  bounds.y1 = std::max<int>(bounds.y1, y - glyph->top + glyph->height);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <os/graphic/DrawOpts.h>
+
+#include <cstdint>
+
+// A string laid out once: UTF-8 decoding, ligatures, kerning and glyph lookups are done by
+// Graphic::shapeText(), after which measuring and drawing the string only walk the placed glyphs.
+// Glyph pointers stay valid as long as the font does and the family's fallback chain is unchanged.
+class ShapedRun {
+ public:
+  struct Glyph {
+    const EpdFontData* fontData;  // font of the fallback chain the glyph came from
+    const EpdGlyph* glyph;
+    int16_t x, y;  // cursor position relative to the text origin, y on the baseline
+  };
+
+  // Ink bounds [x0, x1) x [y0, y1) relative to the text origin
+  struct Bounds {
+    int16_t x0, y0, x1, y1;
+  };
+
+  ShapedRun() = default;
+  ~ShapedRun();
+  ShapedRun(const ShapedRun&) = delete;
+  ShapedRun& operator=(const ShapedRun&) = delete;
+  ShapedRun(ShapedRun&& other) noexcept;
+  ShapedRun& operator=(ShapedRun&& other) noexcept;
+
+  void clear();
+  bool empty() const { return count == 0; }
+  uint16_t size() const { return count; }
+  const Glyph* begin() const { return glyphs; }
+  const Glyph* end() const { return glyphs + count; }
+
+  const char* getText() const { return text ? text : ""; }
+  uint16_t getLength() const { return length; }
+  const TextOpts& getOpts() const { return opts; }
+  // Same as Graphic::getTextWidth() of the string
+  int getWidth() const { return width; }
+  // False for strings of blanks only
+  bool hasInk() const { return bounds.x0 < bounds.x1; }
+  const Bounds& getBounds() const { return bounds; }
+  // Heap bytes held by the run
+  uint32_t byteSize() const;
+
+ private:
+  friend class Graphic;
+
+  Glyph* glyphs = nullptr;  // followed by the NUL-terminated text in the same allocation
+  char* text = nullptr;
+  uint16_t count = 0;
+  uint16_t capacity = 0;
+  uint16_t length = 0;
+  int16_t width = 0;
+  int16_t widthX0 = 0, widthX1 = 0;  // measured extent, blank glyphs and the origin included
+  Bounds bounds = {0, 0, 0, 0};
+  TextOpts opts;
+
+  bool allocate(const char* source, TextOpts textOpts);
+  void append(const EpdFontData* fontData, const EpdGlyph* glyph, int x, int y);
+};
@@ -0,0 +1,203 @@
+#include "Widget.h"
+
+#include <os/graphic/Graphic.h>
+
+#include <algorithm>
+
+namespace {
+constexpr int LIST_TEXT_INSET = 8;  // left padding of list row text
+}  // namespace
+
+void Widget::setBounds(const Rect& r) {
+  if (r.x == bounds.x && r.y == bounds.y && r.w == bounds.w && r.h == bounds.h) return;
+  bounds = r;
+  // The old area has to be cleared as well, which only the parent covers
+  if (parent) {
+    parent->invalidate();
+  } else {
+    invalidate();
+  }
+}
+
+void Widget::setVisible(bool v) {
+  if (visible == v) return;
+  visible = v;
+  invalidate();
+}
+
+void Widget::invalidate() {
+  dirty = true;
+  if (parent) parent->invalidatePart();
+}
+
+void Widget::invalidatePart() {
+  // Ancestors were already told when the flag was set
+  if (partDirty) return;
+  partDirty = true;
+  if (parent) parent->invalidatePart();
+}
+
+bool Widget::paint(Graphic& gfx, bool force) {
+  if (!force && !needsPaint()) return true;
+  if (!gfx.pushClip(bounds.x, bounds.y, bounds.w, bounds.h)) return false;
+  if (visible) {
+    paintContent(gfx, force || dirty);
+  } else if (force || dirty) {
+    clear(gfx, bounds);
+  }
+  gfx.popClip();
+  dirty = partDirty = false;
+  return true;
+}
+
+void Widget::paintContent(Graphic& gfx, bool full) {
+  if (!full) return;
+  clear(gfx, bounds);
+  draw(gfx);
+}
+
+void Widget::clear(Graphic& gfx, const Rect& r) const {
+  BoxOpts opts;
+  opts.fill = true;
+  opts.black = false;
+  gfx.drawBox(r.x, r.y, r.w, r.h, opts);
+}
+
+void Container::adopt(Widget* child) {
+  child->parent = this;
+  children.emplace_back(child);
+  invalidatePart();
+}
+
+void Container::removeAll() {
+  children.clear();
+  invalidate();
+}
+
+void Container::paintContent(Graphic& gfx, bool full) {
+  if (full) {
+    clear(gfx, getBounds());
+    draw(gfx);
+  }
+  for (const auto& child : children) child->paint(gfx, full);
+}
+
+void LabelWidget::setText(const char* t) {
+  if (!t) t = "";
+  if (text == t) return;
+  text = t;
+  invalidate();
+}
+
+void LabelWidget::draw(Graphic& gfx) {
+  if (text.empty() || !opts.font) return;
+  const Rect& b = getBounds();
+  int x = b.x;
+  if (align != Left) {
+    const int slack = b.w - gfx.getLabelWidth(text.c_str(), opts);
+    x += align == Center ? slack / 2 : slack;
+  }
+  const int y = b.y + (b.h - gfx.getLineHeight(*opts.font)) / 2;
+  gfx.drawLabel(text.c_str(), x, y, opts);
+}
+
+ListWidget::ListWidget(const Rect& bounds, TextOpts opts, int rowHeight)
+    : Widget(bounds), opts(opts), rowHeight(std::max(rowHeight, 1)) {}
+
+int ListWidget::getVisibleRows() const { return getBounds().h / rowHeight; }
+
+void ListWidget::setItems(std::vector<std::string> newItems) {
+  items = std::move(newItems);
+  const int count = static_cast<int>(items.size());
+  selected = std::min(selected, count - 1);
+  scroll = std::max(0, std::min(scroll, count - getVisibleRows()));
+  invalidate();
+}
+
+void ListWidget::setSelected(int index) {
+  index = std::max(-1, std::min(index, static_cast<int>(items.size()) - 1));
+  if (index == selected) return;
+  const int previous = selected;
+  selected = index;
+
+  const int rows = getVisibleRows();
+  if (index >= 0 && (index < scroll || index >= scroll + rows)) {
+    setScroll(index < scroll ? index : index - rows + 1);
+    return;
+  }
+  invalidateRow(previous);
+  invalidateRow(index);
+}
+
+void ListWidget::setScroll(int firstRow) {
+  firstRow = std::max(0, std::min(firstRow, static_cast<int>(items.size()) - getVisibleRows()));
+  if (firstRow == scroll) return;
+  scroll = firstRow;
+  invalidate();
+}
+
+void ListWidget::invalidateRow(int index) {
+  const int row = index - scroll;
+  if (index < 0 || row < 0 || row >= getVisibleRows()) return;
+  if (rowDirty.size() <= static_cast<size_t>(row)) rowDirty.resize(getVisibleRows(), 0);
+  rowDirty[row] = 1;
+  invalidatePart();
+}
+
+Rect ListWidget::rowRect(int row) const {
+  const Rect& b = getBounds();
+  return {b.x, b.y + row * rowHeight, b.w, rowHeight};
+}
+
+void ListWidget::paintContent(Graphic& gfx, bool full) {
+  const int rows = getVisibleRows();
+  if (full) {
+    clear(gfx, getBounds());
+    for (int row = 0; row < rows; row++) drawRow(gfx, row);
+  } else {
+    for (size_t row = 0; row < rowDirty.size() && static_cast<int>(row) < rows; row++) {
+      if (!rowDirty[row]) continue;
+      clear(gfx, rowRect(row));
+      drawRow(gfx, row);
+    }
+  }
+  std::fill(rowDirty.begin(), rowDirty.end(), 0);
+}
+
+void ListWidget::drawRow(Graphic& gfx, int row) {
+  const int index = scroll + row;
+  if (index >= static_cast<int>(items.size())) return;
+  const Rect r = rowRect(row);
+  if (!gfx.pushClip(r.x, r.y, r.w, r.h)) return;
+  if (opts.font) {
+    const int y = r.y + (r.h - gfx.getLineHeight(*opts.font)) / 2;
+    gfx.drawLabel(items[index].c_str(), r.x + LIST_TEXT_INSET, y, opts);
+  }
+  if (index == selected) gfx.invertRect(r.x, r.y, r.w, r.h);
+  gfx.popClip();
+}
+
+void ProgressWidget::setPercent(uint8_t p) {
+  p = std::min<uint8_t>(p, 100);
+  if (p == percent) return;
+  percent = p;
+  invalidate();
+}
+
+void ProgressWidget::draw(Graphic& gfx) {
+  const Rect& b = getBounds();
+  gfx.drawProgressBar(b.x, b.y, b.w, b.h, percent);
+}
+
+void ImageWidget::setPath(const char* p) {
+  if (!p) p = "";
+  if (path == p) return;
+  path = p;
+  invalidate();
+}
+
+void ImageWidget::draw(Graphic& gfx) {
+  if (path.empty()) return;
+  const Rect& b = getBounds();
+  gfx.drawImage(ImageSource::file(path.c_str()), b.x, b.y, b.w, b.h, fit);
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <os/graphic/DrawOpts.h>
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Graphic;
+
+// Retained widget tree. Every widget owns its logical bounds and a dirty flag; state setters only invalidate
+// what actually changed, and paint() redraws just the invalidated widgets, each cleared to white and clipped
+// to its bounds. The drawing lands in Graphic's damage tracker, so a following displayDamage() refreshes
+// exactly the repainted areas. Siblings are assumed not to overlap.
+//
+// The tree is shared with the render task: change widgets while holding a RenderLock, then requestUpdate().
+class Widget {
+ public:
+  explicit Widget(const Rect& bounds = {}) : bounds(bounds) {}
+  virtual ~Widget() = default;
+  Widget(const Widget&) = delete;
+  Widget& operator=(const Widget&) = delete;
+
+  const Rect& getBounds() const { return bounds; }
+  void setBounds(const Rect& r);
+  bool isVisible() const { return visible; }
+  void setVisible(bool v);
+
+  // Schedule a full repaint of this widget on the next paint()
+  void invalidate();
+  // Whether anything in this subtree is waiting to be repainted
+  bool needsPaint() const { return dirty || partDirty; }
+
+  // Repaint what was invalidated since the last paint(), or the whole subtree when force is set.
+  // Returns false if the clip stack was full and nothing could be painted.
+  bool paint(Graphic& gfx, bool force = false);
+
+ protected:
+  // Draw the widget inside its bounds, which are already cleared to white and clipped
+  virtual void draw(Graphic& /*gfx*/) {}
+  // Repaint an invalidated or forced widget (full) or just its invalidated parts. The default clears the
+  // bounds and calls draw() when full; widgets that track finer damage override it.
+  virtual void paintContent(Graphic& gfx, bool full);
+  // Record that part of this widget needs repainting, without scheduling a full repaint
+  void invalidatePart();
+  void clear(Graphic& gfx, const Rect& r) const;
+
+ private:
+  friend class Container;
+
+  Widget* parent = nullptr;
+  Rect bounds;
+  bool visible = true;
+  bool dirty = true;
+  bool partDirty = false;
+};
+
+// Groups child widgets. The container owns its children and paints them in insertion order; on a full
+// repaint it clears its whole bounds first, otherwise only the invalidated children repaint.
+class Container : public Widget {
+ public:
+  using Widget::Widget;
+
+  // Construct a child in place; returns nullptr if it could not be allocated
+  template <typename T, typename... Args>
+  T* add(Args&&... args) {
+    T* child = new (std::nothrow) T(std::forward<Args>(args)...);
+    if (child) adopt(child);
+    return child;
+  }
+  void removeAll();
+  size_t size() const { return children.size(); }
+
+ protected:
+  void paintContent(Graphic& gfx, bool full) override;
+
+ private:
+  std::vector<std::unique_ptr<Widget>> children;
+
+  void adopt(Widget* child);
+};
+
+// One line of text drawn through the label cache, vertically centered in its bounds
+class LabelWidget : public Widget {
+ public:
+  enum Align : uint8_t { Left, Center, Right };
+
+  LabelWidget(const Rect& bounds, TextOpts opts, Align align = Left) : Widget(bounds), opts(opts), align(align) {}
+
+  const std::string& getText() const { return text; }
+  void setText(const char* t);
+
+ protected:
+  void draw(Graphic& gfx) override;
+
+ private:
+  std::string text;
+  TextOpts opts;
+  Align align;
+};
+
+// Vertical list of single-line rows with one highlighted (inverted) row. The list tracks damage per row:
+// moving the selection to a neighbouring row repaints those two rows only. Scrolling keeps the selection
+// on screen and repaints the list.
+class ListWidget : public Widget {
+ public:
+  ListWidget(const Rect& bounds, TextOpts opts, int rowHeight);
+
+  void setItems(std::vector<std::string> items);
+  const std::vector<std::string>& getItems() const { return items; }
+  int getSelected() const { return selected; }
+  // Clamped to the items; -1 selects nothing
+  void setSelected(int index);
+  void setScroll(int firstRow);
+  int getScroll() const { return scroll; }
+  int getVisibleRows() const;
+
+ protected:
+  void paintContent(Graphic& gfx, bool full) override;
+
+ private:
+  std::vector<std::string> items;
+  std::vector<uint8_t> rowDirty;  // per visible row
+  TextOpts opts;
+  int rowHeight;
+  int selected = -1;
+  int scroll = 0;
+
+  void invalidateRow(int index);
+  Rect rowRect(int row) const;
+  void drawRow(Graphic& gfx, int row);
+};
+
+// Progress bar, see Graphic::drawProgressBar()
+class ProgressWidget : public Widget {
+ public:
+  using Widget::Widget;
+
+  uint8_t getPercent() const { return percent; }
+  void setPercent(uint8_t p);
+
+ protected:
+  void draw(Graphic& gfx) override;
+
+ private:
+  uint8_t percent = 0;
+};
+
+// PNG or JPEG file fitted into the widget bounds, decoded again on every repaint
+class ImageWidget : public Widget {
+ public:
+  ImageWidget(const Rect& bounds, ImageFit fit = ImageFit::Contain) : Widget(bounds), fit(fit) {}
+
+  const std::string& getPath() const { return path; }
+  void setPath(const char* p);
+
+ protected:
+  void draw(Graphic& gfx) override;
+
+ private:
+  std::string path;
+  ImageFit fit;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 
@@ -20,8 +21,18 @@ class Display {
     FAST_REFRESH,  // Fast refresh using custom LUT
   };
 
+  // Rectangle in physical panel coordinates
+  struct Region {
+    uint16_t x, y, w, h;
+  };
+
   bool turnOffScreen = false;
 
+  // displayRegions() falls back to a full displayBuffer() once the damage covers more than this
+  // percentage of the panel, or would need more than maxPartialWindows separate windows
+  uint8_t partialRefreshThreshold = 40;
+  uint8_t maxPartialWindows = 2;
+
   virtual ~Display() = default;
 
   virtual void begin() = 0;
@@ -36,4 +47,43 @@ class Display {
   // Re-trigger a display refresh without re-writing RAM (useful for grayscale pipeline)
   virtual void refreshDisplay(RefreshMode mode = FAST_REFRESH) = 0;
 
+  // Grayscale overlay for anti-aliased content: after displayBuffer() has shown the black/white frame,
+  // drive the pixels set in the two planes (panel layout, like the framebuffer) to their gray level, then
+  // return the controller to black/white state from the framebuffer. Returns false if unsupported.
+  virtual bool displayGrayBuffer(const uint8_t* /*lsb*/, const uint8_t* /*msb*/) { return false; }
+
+  // Push and refresh only the given regions. x and w must be multiples of 8. Each window costs a
+  // full waveform, so several regions are flushed as their bounding box when that stays under the
+  // threshold; otherwise the whole panel is refreshed with the given mode.
+  virtual void displayRegions(const Region* regions, uint8_t count, RefreshMode mode = FAST_REFRESH) {
+    if (count == 0) return;
+
+    const uint32_t panelArea = static_cast<uint32_t>(getWidth()) * getHeight();
+    const uint32_t limit = panelArea * partialRefreshThreshold / 100;
+
+    uint32_t area = 0;
+    Region bounds = regions[0];
+    for (uint8_t i = 0; i < count; i++) {
+      const Region& r = regions[i];
+      area += static_cast<uint32_t>(r.w) * r.h;
+      const uint16_t x1 = std::max(bounds.x + bounds.w, r.x + r.w);
+      const uint16_t y1 = std::max(bounds.y + bounds.h, r.y + r.h);
+      bounds.x = std::min(bounds.x, r.x);
+      bounds.y = std::min(bounds.y, r.y);
+      bounds.w = x1 - bounds.x;
+      bounds.h = y1 - bounds.y;
+    }
+
+    if (static_cast<uint32_t>(bounds.w) * bounds.h <= limit) {
+      displayWindow(bounds);
+    } else if (area <= limit && count <= maxPartialWindows) {
+      for (uint8_t i = 0; i < count; i++) displayWindow(regions[i]);
+    } else {
+      displayBuffer(mode);
+    }
+  }
+
+ protected:
+  // Push and fast-refresh a single byte-aligned window of the framebuffer
+  virtual void displayWindow(const Region& region) = 0;
 };
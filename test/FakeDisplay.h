@@ -0,0 +1,31 @@
+#pragma once
+
+#include <os/hw/Display.h>
+
+#include <cstring>
+
+// In-memory panel for native tests: an 800x480 framebuffer that counts flushes instead of driving a screen
+class FakeDisplay : public Display {
+ public:
+  static constexpr uint16_t WIDTH = 800;
+  static constexpr uint16_t HEIGHT = 480;
+  static constexpr uint16_t WIDTH_BYTES = WIDTH / 8;
+  static constexpr uint32_t BUFFER_SIZE = static_cast<uint32_t>(WIDTH_BYTES) * HEIGHT;
+
+  uint8_t frameBuffer[BUFFER_SIZE];
+  int fullFlushes = 0;
+  int windowFlushes = 0;
+
+  FakeDisplay() { memset(frameBuffer, 0xFF, sizeof(frameBuffer)); }
+
+  void begin() override {}
+  uint8_t* getFrameBuffer() override { return frameBuffer; }
+  uint16_t getWidth() const override { return WIDTH; }
+  uint16_t getHeight() const override { return HEIGHT; }
+  uint16_t getWidthBytes() const override { return WIDTH_BYTES; }
+  void displayBuffer(RefreshMode) override { fullFlushes++; }
+  void refreshDisplay(RefreshMode) override {}
+
+ protected:
+  void displayWindow(const Region&) override { windowFlushes++; }
+};
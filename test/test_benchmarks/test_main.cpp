@@ -0,0 +1,273 @@
+// Host timings of the rasterizer fast paths against the straightforward code they replaced. Each case also
+// checks that both sides produce the same result; the timings are printed, not asserted.
+#include <EpdFont.h>
+#include <Utf8.h>
+#include <os/graphic/Fonts.h>
+#include <os/graphic/Graphic.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "../FakeDisplay.h"
+
+namespace {
+
+constexpr Graphic::Orientation ORIENTATIONS[] = {Graphic::Portrait, Graphic::LandscapeClockwise,
+                                                 Graphic::PortraitInverted, Graphic::LandscapeCounterClockwise};
+constexpr const char* ORIENTATION_NAMES[] = {"portrait", "landscape cw", "portrait inverted", "landscape ccw"};
+
+FakeDisplay* panel;
+Graphic* gfx;
+
+// Average duration of fn(i) over reps calls, in microseconds
+template <typename Fn>
+double timeUs(int reps, Fn&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) fn(i);
+  const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / reps;
+}
+
+// Graphic::drawPixel() as boxes used to be filled: bounds check, rotation and one read-modify-write per pixel
+void drawPixelReference(Display& display, Graphic::Orientation orientation, int x, int y, bool black) {
+  const bool portrait = orientation == Graphic::Portrait || orientation == Graphic::PortraitInverted;
+  const int width = portrait ? display.getHeight() : display.getWidth();
+  const int height = portrait ? display.getWidth() : display.getHeight();
+  if (x < 0 || x >= width || y < 0 || y >= height) return;
+
+  int phyX = x, phyY = y;
+  switch (orientation) {
+    case Graphic::Portrait:
+      phyX = y;
+      phyY = display.getHeight() - 1 - x;
+      break;
+    case Graphic::LandscapeClockwise:
+      phyX = display.getWidth() - 1 - x;
+      phyY = display.getHeight() - 1 - y;
+      break;
+    case Graphic::PortraitInverted:
+      phyX = display.getWidth() - 1 - y;
+      phyY = x;
+      break;
+    case Graphic::LandscapeCounterClockwise:
+      break;
+  }
+  uint8_t* fb = display.getFrameBuffer();
+  const uint32_t byteIndex = static_cast<uint32_t>(phyY) * display.getWidthBytes() + (phyX / 8);
+  const uint8_t bit = 1 << (7 - (phyX % 8));
+  if (black) {
+    fb[byteIndex] &= ~bit;
+  } else {
+    fb[byteIndex] |= bit;
+  }
+}
+
+// Kerning class of cp from a sorted class map, by binary search as EpdFont::getKerning() did for every pair
+uint8_t searchKernClass(const EpdKernClassEntry* entries, uint16_t count, uint32_t cp) {
+  if (!entries || cp > 0xFFFF) return 0;
+  const EpdKernClassEntry* end = entries + count;
+  const EpdKernClassEntry* it = std::lower_bound(
+      entries, end, cp, [](const EpdKernClassEntry& entry, uint32_t value) { return entry.codepoint < value; });
+  return it != end && it->codepoint == cp ? it->classId : 0;
+}
+
+int8_t searchKerning(const EpdFontData* data, uint32_t leftCp, uint32_t rightCp) {
+  if (!data->kernMatrix) return 0;
+  const uint8_t lc = searchKernClass(data->kernLeftClasses, data->kernLeftEntryCount, leftCp);
+  if (lc == 0) return 0;
+  const uint8_t rc = searchKernClass(data->kernRightClasses, data->kernRightEntryCount, rightCp);
+  if (rc == 0) return 0;
+  return data->kernMatrix[(lc - 1) * data->kernRightClassCount + (rc - 1)];
+}
+
+// A page of body text under a title bar, the usual content of a full flush
+void drawPage(Graphic& g) {
+  BoxOpts box;
+  box.fill = true;
+  box.black = false;
+  g.drawBox(0, 0, g.getWidth(), g.getHeight(), box);
+  box.black = true;
+  g.drawBox(0, 0, g.getWidth(), 40, box);
+
+  TextOpts opts;
+  opts.font = &getFontFamilyById(NOTOSANS_14_FONT_ID);
+  const int lineHeight = g.getLineHeight(*opts.font);
+  for (int y = 48; y + lineHeight <= g.getHeight(); y += lineHeight) {
+    g.drawText("The quick brown fox jumps over the lazy dog, again and again.", 12, y, opts);
+  }
+}
+
+}  // namespace
+
+void setUp() {
+  panel = new FakeDisplay();
+  gfx = new Graphic(*panel);
+}
+
+void tearDown() {
+  delete gfx;
+  delete panel;
+}
+
+// drawBox() fills physical spans with masked edge bytes and memset; it used to call drawPixel() per pixel
+void test_box_fill_spans_vs_per_pixel() {
+  static uint8_t expected[FakeDisplay::BUFFER_SIZE];
+  // An odd rectangle, so the spans have partial edge bytes in every orientation
+  constexpr int X = 13, Y = 7, W = 411, H = 397;
+
+  for (Graphic::Orientation orientation : ORIENTATIONS) {
+    gfx->setOrientation(orientation);
+    BoxOpts box;
+    box.fill = true;
+
+    // Even rep counts, so both sides finish on a black pass
+    const double perPixelUs = timeUs(20, [&](int i) {
+      for (int y = Y; y < Y + H; y++) {
+        for (int x = X; x < X + W; x++) drawPixelReference(*panel, orientation, x, y, i % 2 == 1);
+      }
+    });
+    memcpy(expected, panel->frameBuffer, sizeof(expected));
+
+    const double spanUs = timeUs(2000, [&](int i) {
+      box.black = i % 2 == 1;
+      gfx->drawBox(X, Y, W, H, box);
+    });
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, panel->frameBuffer, sizeof(expected),
+                                     ORIENTATION_NAMES[orientation]);
+
+    char line[128];
+    snprintf(line, sizeof(line), "fill %dx%d %-17s spans %8.2f us, per pixel %8.2f us (%.0fx)", W, H,
+             ORIENTATION_NAMES[orientation], spanUs, perPixelUs, perPixelUs / spanUs);
+    TEST_MESSAGE(line);
+  }
+}
+
+// LogicalBackBuffer draws in logical orientation and converts the plane to the panel layout on every flush
+void test_back_buffer_resolve_cost() {
+  for (Graphic::Orientation orientation : ORIENTATIONS) {
+    gfx->setOrientation(orientation);
+    drawPage(*gfx);
+    const double directPageUs = timeUs(50, [&](int) {
+      drawPage(*gfx);
+      gfx->displayBuffer();
+    });
+
+    FakeDisplay* logicalPanel = new FakeDisplay();
+    Graphic* logical = new Graphic(*logicalPanel);
+    logical->setOrientation(orientation);
+    TEST_ASSERT_TRUE(logical->setRenderMode(Graphic::LogicalBackBuffer));
+    drawPage(*logical);
+    const double resolveUs = timeUs(200, [&](int) { logical->displayBuffer(); });
+    const double logicalPageUs = timeUs(50, [&](int) {
+      drawPage(*logical);
+      logical->displayBuffer();
+    });
+    const bool same = memcmp(panel->frameBuffer, logicalPanel->frameBuffer, FakeDisplay::BUFFER_SIZE) == 0;
+    delete logical;
+    delete logicalPanel;
+    TEST_ASSERT_TRUE_MESSAGE(same, ORIENTATION_NAMES[orientation]);
+
+    char line[128];
+    snprintf(line, sizeof(line), "page %-17s direct %8.2f us, back buffer %8.2f us of which resolve %6.2f us",
+             ORIENTATION_NAMES[orientation], directPageUs, logicalPageUs, resolveUs);
+    TEST_MESSAGE(line);
+  }
+}
+
+// Code points below EpdFont::DIRECT_KERN_COUNT read their kerning classes from dense tables instead of
+// binary searching the class maps
+void test_direct_kern_class_lookup() {
+  const EpdFontFamily& family = getFontFamilyById(NOTOSANS_14_FONT_ID);
+  const EpdFontData* data = family.getData(EpdFontFamily::REGULAR);
+  TEST_ASSERT_NOT_NULL(data->kernMatrix);
+  EpdFont font(data);
+
+  // Every pair covered by the tables, and a little past them where both sides search
+  for (uint32_t left = 0; left < 0x200; left++) {
+    for (uint32_t right = 0; right < 0x200; right++) {
+      if (font.getKerning(left, right) != searchKerning(data, left, right)) {
+        char message[64];
+        snprintf(message, sizeof(message), "U+%04lX U+%04lX", static_cast<unsigned long>(left),
+                 static_cast<unsigned long>(right));
+        TEST_FAIL_MESSAGE(message);
+      }
+    }
+  }
+
+  // Adjacent pairs of running Latin text
+  const char* text = "Wavy AVATAR ToWard: \"Très café\", naïve façade, Ärger über Öl, Łódź, Værløse, "
+                     "the quick brown fox jumps over the lazy dog.";
+  uint32_t cps[256];
+  size_t count = 0;
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+  while (count < 256 && (cps[count] = utf8NextCodepoint(&p))) count++;
+
+  volatile int sink = 0;
+  const double directNs = 1000 * timeUs(20000, [&](int) {
+    int sum = 0;
+    for (size_t i = 1; i < count; i++) sum += font.getKerning(cps[i - 1], cps[i]);
+    sink = sum;
+  }) / (count - 1);
+  const double searchNs = 1000 * timeUs(20000, [&](int) {
+    int sum = 0;
+    for (size_t i = 1; i < count; i++) sum += searchKerning(data, cps[i - 1], cps[i]);
+    sink = sum;
+  }) / (count - 1);
+  (void)sink;
+
+  char line[128];
+  snprintf(line, sizeof(line), "kerning pair: direct %6.2f ns, binary search %6.2f ns (%.1fx)", directNs,
+           searchNs, searchNs / directNs);
+  TEST_MESSAGE(line);
+}
+
+// getTextDimensions() of a paragraph, the measurement line layout repeats for every line, with kerning
+// classes from the direct tables and, on a second font over the same data, from the binary search alone
+void test_paragraph_dimensions_with_direct_kerning() {
+  const EpdFontData* data = getFontFamilyById(NOTOSANS_14_FONT_ID).getData(EpdFontFamily::REGULAR);
+  EpdFont direct(data);
+  EpdFont search(data);
+  search.setDirectKerning(false);
+
+  const char* paragraph =
+      "When Mr. Bilbo Baggins of Bag End announced that he would shortly be celebrating his eleventy-first "
+      "birthday with a party of special magnificence, there was much talk and excitement in Hobbiton. "
+      "Bilbo was very rich and very peculiar, and had been the wonder of the Shire for sixty years, ever "
+      "since his remarkable disappearance and unexpected return. \"Wavy AVATAR, Très café!\" said Tom.";
+
+  int directW, directH, searchW, searchH;
+  direct.getTextDimensions(paragraph, &directW, &directH);
+  search.getTextDimensions(paragraph, &searchW, &searchH);
+  TEST_ASSERT_EQUAL(searchW, directW);
+  TEST_ASSERT_EQUAL(searchH, directH);
+
+  volatile int sink = 0;
+  const double directUs = timeUs(2000, [&](int) {
+    int w, h;
+    direct.getTextDimensions(paragraph, &w, &h);
+    sink = w;
+  });
+  const double searchUs = timeUs(2000, [&](int) {
+    int w, h;
+    search.getTextDimensions(paragraph, &w, &h);
+    sink = w;
+  });
+  (void)sink;
+
+  char line[128];
+  snprintf(line, sizeof(line), "paragraph of %u bytes: direct kerning %6.2f us, binary search %6.2f us (%.1fx)",
+           static_cast<unsigned>(strlen(paragraph)), directUs, searchUs, searchUs / directUs);
+  TEST_MESSAGE(line);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_box_fill_spans_vs_per_pixel);
+  RUN_TEST(test_back_buffer_resolve_cost);
+  RUN_TEST(test_direct_kern_class_lookup);
+  RUN_TEST(test_paragraph_dimensions_with_direct_kerning);
+  return UNITY_END();
+}
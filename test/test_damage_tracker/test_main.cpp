@@ -0,0 +1,160 @@
+#include <os/graphic/DamageTracker.h>
+#include <os/graphic/Fonts.h>
+#include <os/graphic/Graphic.h>
+#include <unity.h>
+
+#include <cstring>
+
+#include "../FakeDisplay.h"
+
+namespace {
+
+constexpr uint16_t PANEL_W = FakeDisplay::WIDTH;
+constexpr uint16_t PANEL_H = FakeDisplay::HEIGHT;
+
+bool covers(const Display::Region& r, int x, int y) {
+  return x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h;
+}
+
+bool coveredByAny(const DamageTracker& damage, int x, int y) {
+  for (uint8_t i = 0; i < damage.size(); i++) {
+    if (covers(damage.data()[i], x, y)) return true;
+  }
+  return false;
+}
+
+void assertRegion(const Display::Region& r, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  TEST_ASSERT_EQUAL(x, r.x);
+  TEST_ASSERT_EQUAL(y, r.y);
+  TEST_ASSERT_EQUAL(w, r.w);
+  TEST_ASSERT_EQUAL(h, r.h);
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_regions_snap_to_bytes_and_clip_to_panel() {
+  DamageTracker damage;
+  damage.add(3, 5, 10, 4, PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(1, damage.size());
+  assertRegion(damage.data()[0], 0, 5, 16, 4);
+
+  damage.clear();
+  damage.add(-10, -10, 20, 20, PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(1, damage.size());
+  assertRegion(damage.data()[0], 0, 0, 16, 10);
+
+  damage.clear();
+  damage.add(PANEL_W - 3, PANEL_H - 2, 10, 10, PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(1, damage.size());
+  assertRegion(damage.data()[0], PANEL_W - 8, PANEL_H - 2, 8, 2);
+
+  damage.clear();
+  damage.add(PANEL_W, 0, 10, 10, PANEL_W, PANEL_H);
+  damage.add(0, -20, 10, 20, PANEL_W, PANEL_H);
+  damage.add(50, 50, 0, 10, PANEL_W, PANEL_H);
+  TEST_ASSERT_TRUE(damage.empty());
+}
+
+void test_nearby_regions_merge() {
+  DamageTracker damage;
+  // The glyphs of a line: small gaps between them
+  for (int x = 16; x < 400; x += 20) damage.add(x, 100, 14, 24, PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(1, damage.size());
+  assertRegion(damage.data()[0], 16, 100, 400, 24);
+
+  // Far away stays separate
+  damage.add(600, 400, 16, 16, PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(2, damage.size());
+  TEST_ASSERT_EQUAL(400 * 24 + 16 * 16, damage.area());
+}
+
+void test_bridging_region_absorbs_both_neighbours() {
+  DamageTracker damage;
+  damage.add(0, 0, 16, 16, PANEL_W, PANEL_H);
+  damage.add(200, 0, 16, 16, PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(2, damage.size());
+
+  damage.add(16, 0, 184, 4, PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(1, damage.size());
+  assertRegion(damage.data()[0], 0, 0, 216, 16);
+}
+
+void test_full_set_still_covers_everything_added() {
+  DamageTracker damage;
+  Display::Region added[3 * DamageTracker::MAX_REGIONS];
+  for (uint8_t i = 0; i < sizeof(added) / sizeof(added[0]); i++) {
+    // A scatter of small, mutually distant rectangles
+    const uint16_t x = static_cast<uint16_t>((i * 173) % (PANEL_W - 16)) & ~7;
+    const uint16_t y = static_cast<uint16_t>((i * 97) % (PANEL_H - 16));
+    added[i] = {x, y, 8, 8};
+    damage.add(x, y, 8, 8, PANEL_W, PANEL_H);
+    TEST_ASSERT_LESS_OR_EQUAL(DamageTracker::MAX_REGIONS, damage.size());
+  }
+  for (const Display::Region& r : added) {
+    TEST_ASSERT_TRUE(coveredByAny(damage, r.x, r.y));
+    TEST_ASSERT_TRUE(coveredByAny(damage, r.x + r.w - 1, r.y + r.h - 1));
+  }
+
+  damage.addAll(PANEL_W, PANEL_H);
+  TEST_ASSERT_EQUAL(1, damage.size());
+  assertRegion(damage.data()[0], 0, 0, PANEL_W, PANEL_H);
+}
+
+// Every framebuffer byte Graphic changes must lie in the damage it reports, in every orientation
+void test_graphic_damage_covers_changed_pixels() {
+  static uint8_t before[FakeDisplay::BUFFER_SIZE];
+  constexpr Graphic::Orientation orientations[] = {Graphic::Portrait, Graphic::LandscapeClockwise,
+                                                   Graphic::PortraitInverted, Graphic::LandscapeCounterClockwise};
+  FakeDisplay* panel = new FakeDisplay();
+  Graphic* gfx = new Graphic(*panel);
+
+  for (Graphic::Orientation orientation : orientations) {
+    gfx->setOrientation(orientation);
+    gfx->displayBuffer();
+    memcpy(before, panel->frameBuffer, sizeof(before));
+
+    BoxOpts box;
+    gfx->drawBox(31, 17, 45, 29, box);
+    ShapeOpts shape;
+    shape.fill = true;
+    gfx->drawCircle(200, 150, 23, shape);
+    gfx->drawLine(5, 300, 170, 330);
+    TextOpts text;
+    text.font = &getFontFamilyById(NOTOSANS_14_FONT_ID);
+    gfx->drawText("Damage", 90, 220, text);
+
+    const DamageTracker& damage = gfx->getDamage();
+    TEST_ASSERT_FALSE(damage.empty());
+    bool changed = false;
+    for (int y = 0; y < PANEL_H; y++) {
+      for (int xb = 0; xb < FakeDisplay::WIDTH_BYTES; xb++) {
+        const uint32_t i = static_cast<uint32_t>(y) * FakeDisplay::WIDTH_BYTES + xb;
+        if (before[i] == panel->frameBuffer[i]) continue;
+        changed = true;
+        TEST_ASSERT_TRUE_MESSAGE(coveredByAny(damage, xb * 8, y), "changed byte outside the damage");
+      }
+    }
+    TEST_ASSERT_TRUE(changed);
+
+    BoxOpts white;
+    white.fill = true;
+    white.black = false;
+    gfx->drawBox(0, 0, gfx->getWidth(), gfx->getHeight(), white);
+  }
+
+  delete gfx;
+  delete panel;
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_regions_snap_to_bytes_and_clip_to_panel);
+  RUN_TEST(test_nearby_regions_merge);
+  RUN_TEST(test_bridging_region_absorbs_both_neighbours);
+  RUN_TEST(test_full_set_still_covers_everything_added);
+  RUN_TEST(test_graphic_damage_covers_changed_pixels);
+  return UNITY_END();
+}
@@ -0,0 +1,218 @@
+#include <os/graphic/DisplayList.h>
+#include <os/graphic/Fonts.h>
+#include <os/graphic/Graphic.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "../FakeDisplay.h"
+
+namespace {
+
+constexpr DisplayList::Bounds SCREEN = {0, 0, 480, 800};
+
+FakeDisplay* retainedPanel;
+FakeDisplay* immediatePanel;
+Graphic* retained;
+Graphic* immediate;
+
+// Which of the frame's elements differ from the base frame
+enum Change : uint8_t {
+  NONE = 0,
+  MOVE_BOX = 1,
+  EDIT_TEXT = 2,
+  DROP_CIRCLE = 4,
+};
+
+void drawFrame(Graphic& g, uint8_t changes) {
+  BoxOpts box;
+  box.fill = true;
+  g.drawBox(20, (changes & MOVE_BOX) ? 60 : 40, 120, 30, box);
+
+  TextOpts text;
+  text.font = &getFontFamilyById(NOTOSANS_14_FONT_ID);
+  g.drawText((changes & EDIT_TEXT) ? "Chapter 2 of 12" : "Chapter 1 of 12", 20, 200, text);
+  g.drawText("A line that never changes", 20, 400, text);
+
+  if (!(changes & DROP_CIRCLE)) {
+    ShapeOpts shape;
+    shape.stroke = 3;
+    g.drawCircle(300, 600, 40, shape);
+  }
+  g.invertRect(10, 390, 300, 40);
+}
+
+// Draw the frame immediately on a white screen, as the retained frame should end up
+void drawExpected(uint8_t changes) {
+  BoxOpts white;
+  white.fill = true;
+  white.black = false;
+  immediate->drawBox(0, 0, immediate->getWidth(), immediate->getHeight(), white);
+  drawFrame(*immediate, changes);
+}
+
+void recordFrame(uint8_t changes) {
+  retained->displayBuffer();  // start from empty damage
+  retained->beginFrame();
+  drawFrame(*retained, changes);
+  retained->endFrame();
+}
+
+void assertSameScreen() {
+  TEST_ASSERT_EQUAL_MEMORY(immediatePanel->frameBuffer, retainedPanel->frameBuffer, FakeDisplay::BUFFER_SIZE);
+}
+
+// Logical row span [y0, y1) of the damage, portrait orientation
+void damageRows(int* y0, int* y1) {
+  const DamageTracker& damage = retained->getDamage();
+  *y0 = INT32_MAX;
+  *y1 = INT32_MIN;
+  for (uint8_t i = 0; i < damage.size(); i++) {
+    // Portrait: logical y is the physical x
+    const Display::Region& r = damage.data()[i];
+    *y0 = std::min<int>(*y0, r.x);
+    *y1 = std::max<int>(*y1, r.x + r.w);
+  }
+}
+
+}  // namespace
+
+void setUp() {
+  retainedPanel = new FakeDisplay();
+  immediatePanel = new FakeDisplay();
+  retained = new Graphic(*retainedPanel);
+  immediate = new Graphic(*immediatePanel);
+}
+
+void tearDown() {
+  delete retained;
+  delete immediate;
+  delete retainedPanel;
+  delete immediatePanel;
+}
+
+void test_equal_commands_compare_and_hash_equal() {
+  DisplayList a, b;
+  BoxOpts box;
+  box.fill = true;
+  a.addBox(1, 2, 3, 4, box, SCREEN, SCREEN);
+  b.addBox(1, 2, 3, 4, box, SCREEN, SCREEN);
+  TextOpts text;
+  text.font = &getFontFamilyById(NOTOSANS_14_FONT_ID);
+  text.style = EpdFontFamily::BOLD;
+  a.addText("same", 5, 6, text, SCREEN, SCREEN);
+  b.addText("same", 5, 6, text, SCREEN, SCREEN);
+
+  TEST_ASSERT_EQUAL(2, a.size());
+  for (uint32_t i = 0; i < a.size(); i++) {
+    TEST_ASSERT_EQUAL(a[i].hash, b[i].hash);
+    TEST_ASSERT_TRUE(a[i].equals(b[i]));
+  }
+
+  // Payloads read back as recorded
+  TEST_ASSERT_TRUE(a[0].boxOpts().fill);
+  TEST_ASSERT_TRUE(a[0].boxOpts().black);
+  TEST_ASSERT_EQUAL_PTR(text.font, a[1].textOpts().font);
+  TEST_ASSERT_EQUAL(EpdFontFamily::BOLD, a[1].textOpts().style);
+  TEST_ASSERT_EQUAL_STRING("same", a[1].text());
+}
+
+void test_differing_commands_do_not_compare_equal() {
+  DisplayList list;
+  BoxOpts box;
+  list.addBox(1, 2, 3, 4, box, SCREEN, SCREEN);
+  list.addBox(1, 2, 3, 5, box, SCREEN, SCREEN);
+  box.black = false;
+  list.addBox(1, 2, 3, 4, box, SCREEN, SCREEN);
+  TextOpts text;
+  text.font = &getFontFamilyById(NOTOSANS_14_FONT_ID);
+  list.addText("one", 5, 6, text, SCREEN, SCREEN);
+  list.addText("two", 5, 6, text, SCREEN, SCREEN);
+  list.addText("one", 5, 6, text, SCREEN, SCREEN, DisplayList::Op::Label);
+  DisplayList::ShapeRef shape = {DisplayList::ShapeRef::Arc, ShapeOpts(), 10, 0, 90};
+  list.addShape(shape, 50, 50, 0, 0, SCREEN, SCREEN);
+  shape.endAngle = 180;
+  list.addShape(shape, 50, 50, 0, 0, SCREEN, SCREEN);
+
+  for (uint32_t i = 0; i < list.size(); i++) {
+    for (uint32_t j = 0; j < list.size(); j++) {
+      TEST_ASSERT_EQUAL(i == j, list[i].equals(list[j]));
+    }
+  }
+  TEST_ASSERT_EQUAL(180, list[list.size() - 1].shapeRef().endAngle);
+}
+
+void test_first_frame_starts_from_white() {
+  // Leftovers from immediate-mode drawing must not survive the first retained frame
+  BoxOpts black;
+  black.fill = true;
+  retained->drawBox(0, 0, retained->getWidth(), retained->getHeight(), black);
+
+  recordFrame(NONE);
+  drawExpected(NONE);
+  assertSameScreen();
+}
+
+void test_unchanged_frame_redraws_nothing() {
+  recordFrame(NONE);
+  recordFrame(NONE);
+  TEST_ASSERT_TRUE(retained->getDamage().empty());
+  drawExpected(NONE);
+  assertSameScreen();
+}
+
+void test_changes_redraw_only_their_regions() {
+  recordFrame(NONE);
+
+  recordFrame(EDIT_TEXT);
+  drawExpected(EDIT_TEXT);
+  assertSameScreen();
+  int y0, y1;
+  damageRows(&y0, &y1);
+  // Only the edited line, nowhere near the box above or the lines and circle below
+  TEST_ASSERT_GREATER_THAN(70, y0);
+  TEST_ASSERT_LESS_THAN(390, y1);
+
+  recordFrame(EDIT_TEXT | MOVE_BOX);
+  drawExpected(EDIT_TEXT | MOVE_BOX);
+  assertSameScreen();
+  damageRows(&y0, &y1);
+  TEST_ASSERT_LESS_OR_EQUAL(40, y0);
+  TEST_ASSERT_LESS_THAN(200, y1);
+
+  recordFrame(EDIT_TEXT | MOVE_BOX | DROP_CIRCLE);
+  drawExpected(EDIT_TEXT | MOVE_BOX | DROP_CIRCLE);
+  assertSameScreen();
+  damageRows(&y0, &y1);
+  TEST_ASSERT_GREATER_THAN(430, y0);
+
+  // Back to the first frame in one step
+  recordFrame(NONE);
+  drawExpected(NONE);
+  assertSameScreen();
+}
+
+void test_invalidated_frame_is_redrawn_whole() {
+  recordFrame(NONE);
+  BoxOpts black;
+  black.fill = true;
+  retained->drawBox(200, 300, 50, 50, black);
+  retained->invalidateFrame();
+
+  recordFrame(NONE);
+  drawExpected(NONE);
+  assertSameScreen();
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_equal_commands_compare_and_hash_equal);
+  RUN_TEST(test_differing_commands_do_not_compare_equal);
+  RUN_TEST(test_first_frame_starts_from_white);
+  RUN_TEST(test_unchanged_frame_redraws_nothing);
+  RUN_TEST(test_changes_redraw_only_their_regions);
+  RUN_TEST(test_invalidated_frame_is_redrawn_whole);
+  return UNITY_END();
+}
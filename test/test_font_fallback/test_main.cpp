@@ -0,0 +1,156 @@
+// EpdFontFamily fallback chains and the resolve cache in front of them
+#include <EpdFontFamily.h>
+#include <Utf8.h>
+#include <os/graphic/Fonts.h>
+#include <unity.h>
+
+#include <vector>
+
+namespace {
+
+constexpr uint32_t E_ACUTE = 0xE9;
+constexpr uint32_t ZHE = 0x416;
+constexpr uint32_t CJK = 0x4E00;  // in no builtin font
+
+// NotoSans 14 cut down to ASCII and the replacement glyph, like a subsetted builtin font
+struct AsciiFont {
+  std::vector<EpdUnicodeInterval> intervals;
+  EpdFontData data;
+  EpdFont font;
+
+  explicit AsciiFont(const EpdFontData* full) : data(*full), font(&data) {
+    for (uint32_t i = 0; i < full->intervalCount; i++) {
+      const EpdUnicodeInterval& interval = full->intervals[i];
+      if (interval.last < 0x80 || interval.first == REPLACEMENT_GLYPH) intervals.push_back(interval);
+    }
+    data.intervals = intervals.data();
+    data.intervalCount = static_cast<uint32_t>(intervals.size());
+  }
+};
+
+const EpdFontFamily& notoSans14() { return getFontFamilyById(NOTOSANS_14_FONT_ID); }
+
+AsciiFont* asciiRegular;
+AsciiFont* asciiBold;
+EpdFont* fullRegular;
+EpdFontFamily* primary;   // ASCII regular and bold
+EpdFontFamily* fallback;  // full NotoSans 14, regular only
+
+void assertResolvesTo(const EpdFontFamily::ResolvedGlyph& resolved, const EpdFont* font, uint32_t cp) {
+  int32_t index;
+  const EpdGlyph* glyph = font->getGlyph(cp, &index);
+  TEST_ASSERT_NOT_NULL(glyph);
+  TEST_ASSERT_EQUAL_PTR(font, resolved.font);
+  TEST_ASSERT_EQUAL_PTR(glyph, resolved.glyph);
+  TEST_ASSERT_EQUAL(index, resolved.index);
+}
+
+}  // namespace
+
+void setUp() {
+  asciiRegular = new AsciiFont(notoSans14().getData(EpdFontFamily::REGULAR));
+  asciiBold = new AsciiFont(notoSans14().getData(EpdFontFamily::BOLD));
+  fullRegular = new EpdFont(notoSans14().getData(EpdFontFamily::REGULAR));
+  primary = new EpdFontFamily(&asciiRegular->font, &asciiBold->font);
+  fallback = new EpdFontFamily(fullRegular);
+}
+
+void tearDown() {
+  delete primary;
+  delete fallback;
+  delete fullRegular;
+  delete asciiBold;
+  delete asciiRegular;
+}
+
+void test_missing_codepoints_resolve_from_the_fallback() {
+  TEST_ASSERT_NULL(asciiRegular->font.findGlyph(E_ACUTE));
+  TEST_ASSERT_TRUE(primary->addFallback(fallback));
+
+  // Twice: the first walks the chain, the second is answered by the cache
+  for (int pass = 0; pass < 2; pass++) {
+    assertResolvesTo(primary->resolveGlyph(E_ACUTE), fullRegular, E_ACUTE);
+    assertResolvesTo(primary->resolveGlyph(ZHE), fullRegular, ZHE);
+    assertResolvesTo(primary->resolveGlyph('A'), &asciiRegular->font, 'A');
+    assertResolvesTo(primary->resolveGlyph('A', EpdFontFamily::BOLD), &asciiBold->font, 'A');
+  }
+
+  // Nobody has it: the primary's replacement glyph
+  for (int pass = 0; pass < 2; pass++) {
+    assertResolvesTo(primary->resolveGlyph(CJK), &asciiRegular->font, REPLACEMENT_GLYPH);
+  }
+}
+
+void test_fallbacks_are_consulted_in_order() {
+  EpdFontFamily asciiOnly(&asciiBold->font);
+  TEST_ASSERT_TRUE(primary->addFallback(&asciiOnly));
+  TEST_ASSERT_TRUE(primary->addFallback(fallback));
+  assertResolvesTo(primary->resolveGlyph(E_ACUTE), fullRegular, E_ACUTE);
+  assertResolvesTo(primary->resolveGlyph(E_ACUTE), fullRegular, E_ACUTE);
+}
+
+void test_style_missing_in_fallback_uses_its_regular_font() {
+  TEST_ASSERT_TRUE(primary->addFallback(fallback));
+  for (const auto style : {EpdFontFamily::BOLD, EpdFontFamily::ITALIC, EpdFontFamily::BOLD_ITALIC}) {
+    assertResolvesTo(primary->resolveGlyph(E_ACUTE, style), fullRegular, E_ACUTE);
+  }
+  // The primary's own bold still wins where it has the glyph
+  assertResolvesTo(primary->resolveGlyph('b', EpdFontFamily::BOLD), &asciiBold->font, 'b');
+  assertResolvesTo(primary->resolveGlyph('b', EpdFontFamily::REGULAR), &asciiRegular->font, 'b');
+}
+
+void test_chain_length_is_limited() {
+  EpdFontFamily extra[EpdFontFamily::MAX_FALLBACKS + 1] = {
+      EpdFontFamily(fullRegular), EpdFontFamily(fullRegular), EpdFontFamily(fullRegular),
+      EpdFontFamily(fullRegular)};
+  static_assert(EpdFontFamily::MAX_FALLBACKS == 3, "extra[] holds one family too many");
+
+  TEST_ASSERT_FALSE(primary->addFallback(nullptr));
+  TEST_ASSERT_FALSE(primary->addFallback(primary));
+  for (uint8_t i = 0; i < EpdFontFamily::MAX_FALLBACKS; i++) {
+    TEST_ASSERT_TRUE(primary->addFallback(&extra[i]));
+  }
+  TEST_ASSERT_FALSE(primary->addFallback(&extra[EpdFontFamily::MAX_FALLBACKS]));
+
+  primary->clearFallbacks();
+  TEST_ASSERT_TRUE(primary->addFallback(&extra[EpdFontFamily::MAX_FALLBACKS]));
+}
+
+// cp and cp ^ 128 share a cache entry; each lookup replaces the other's
+void test_colliding_codepoints_replace_each_other() {
+  TEST_ASSERT_TRUE(primary->addFallback(fallback));
+  const uint32_t colliding = E_ACUTE ^ 128;  // 'i', from the primary
+  for (int pass = 0; pass < 3; pass++) {
+    assertResolvesTo(primary->resolveGlyph(E_ACUTE), fullRegular, E_ACUTE);
+    assertResolvesTo(primary->resolveGlyph(colliding), &asciiRegular->font, colliding);
+  }
+  // Same entry, different style
+  assertResolvesTo(primary->resolveGlyph(colliding, EpdFontFamily::BOLD), &asciiBold->font, colliding);
+  assertResolvesTo(primary->resolveGlyph(colliding), &asciiRegular->font, colliding);
+}
+
+void test_cleared_chain_forgets_cached_fallback_glyphs() {
+  TEST_ASSERT_TRUE(primary->addFallback(fallback));
+  assertResolvesTo(primary->resolveGlyph(E_ACUTE), fullRegular, E_ACUTE);
+  assertResolvesTo(primary->resolveGlyph(ZHE), fullRegular, ZHE);
+
+  primary->clearFallbacks();
+  assertResolvesTo(primary->resolveGlyph(E_ACUTE), &asciiRegular->font, REPLACEMENT_GLYPH);
+  assertResolvesTo(primary->resolveGlyph(ZHE), &asciiRegular->font, REPLACEMENT_GLYPH);
+
+  // A new chain is resolved afresh, not from entries of the old one
+  EpdFontFamily asciiOnly(&asciiBold->font);
+  TEST_ASSERT_TRUE(primary->addFallback(&asciiOnly));
+  assertResolvesTo(primary->resolveGlyph(E_ACUTE), &asciiRegular->font, REPLACEMENT_GLYPH);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_missing_codepoints_resolve_from_the_fallback);
+  RUN_TEST(test_fallbacks_are_consulted_in_order);
+  RUN_TEST(test_style_missing_in_fallback_uses_its_regular_font);
+  RUN_TEST(test_chain_length_is_limited);
+  RUN_TEST(test_colliding_codepoints_replace_each_other);
+  RUN_TEST(test_cleared_chain_forgets_cached_fallback_glyphs);
+  return UNITY_END();
+}
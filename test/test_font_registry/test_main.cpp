@@ -0,0 +1,101 @@
+// findFontFamilyById() looks IDs up through a perfect hash whose seed is searched at compile time
+#include <os/graphic/Fonts.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+namespace {
+
+#define FONT_ID(id, ...) id,
+constexpr int32_t FONT_IDS[] = {BUILTIN_FONT_FAMILIES(FONT_ID)};
+#undef FONT_ID
+constexpr size_t FONT_COUNT = std::size(FONT_IDS);
+
+bool isBuiltin(int32_t id) {
+  return std::find(std::begin(FONT_IDS), std::end(FONT_IDS), id) != std::end(FONT_IDS);
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_builtin_id_finds_its_own_family() {
+  const EpdFontFamily* families[FONT_COUNT];
+  for (size_t i = 0; i < FONT_COUNT; i++) {
+    families[i] = findFontFamilyById(FONT_IDS[i]);
+    TEST_ASSERT_NOT_NULL(families[i]);
+    // Constructed once, then handed out again
+    TEST_ASSERT_EQUAL_PTR(families[i], findFontFamilyById(FONT_IDS[i]));
+    TEST_ASSERT_EQUAL_PTR(families[i], &getFontFamilyById(FONT_IDS[i]));
+  }
+  // No two IDs share a slot, so no two share a family or font data
+  for (size_t i = 0; i < FONT_COUNT; i++) {
+    for (size_t j = i + 1; j < FONT_COUNT; j++) {
+      TEST_ASSERT_TRUE(families[i] != families[j]);
+      TEST_ASSERT_TRUE(families[i]->getData() != families[j]->getData());
+    }
+  }
+}
+
+void test_unknown_ids_are_not_found() {
+  TEST_ASSERT_NULL(findFontFamilyById(0));
+  TEST_ASSERT_NULL(findFontFamilyById(-1));
+  TEST_ASSERT_NULL(findFontFamilyById(INT32_MIN));
+  TEST_ASSERT_NULL(findFontFamilyById(INT32_MAX));
+
+  // IDs of all kinds, most of which hash to occupied slots and must fail the ID check there
+  uint32_t state = 12345;
+  for (int i = 0; i < 100000; i++) {
+    state = state * 1664525u + 1013904223u;
+    const int32_t id = static_cast<int32_t>(state);
+    if (isBuiltin(id)) continue;
+    TEST_ASSERT_NULL(findFontFamilyById(id));
+  }
+  // Neighbours of real IDs
+  for (int32_t id : FONT_IDS) {
+    if (!isBuiltin(id + 1)) TEST_ASSERT_NULL(findFontFamilyById(id + 1));
+    if (!isBuiltin(id - 1)) TEST_ASSERT_NULL(findFontFamilyById(id - 1));
+  }
+}
+
+void test_families_keep_their_styles() {
+  // Reading fonts have all four styles, the UI fonts regular and bold, the small font regular only
+  const EpdFontFamily& reading = getFontFamilyById(NOTOSANS_14_FONT_ID);
+  TEST_ASSERT_TRUE(reading.getData(EpdFontFamily::BOLD) != reading.getData(EpdFontFamily::REGULAR));
+  TEST_ASSERT_TRUE(reading.getData(EpdFontFamily::ITALIC) != reading.getData(EpdFontFamily::REGULAR));
+  TEST_ASSERT_TRUE(reading.getData(EpdFontFamily::BOLD_ITALIC) != reading.getData(EpdFontFamily::BOLD));
+
+  const EpdFontFamily& ui = getFontFamilyById(UI_10_FONT_ID);
+  TEST_ASSERT_TRUE(ui.getData(EpdFontFamily::BOLD) != ui.getData(EpdFontFamily::REGULAR));
+
+  const EpdFontFamily& small = getFontFamilyById(SMALL_FONT_ID);
+  TEST_ASSERT_EQUAL_PTR(small.getData(EpdFontFamily::REGULAR), small.getData(EpdFontFamily::BOLD));
+}
+
+// Groups a build omits keep their IDs, which then resolve to nothing
+void test_omitted_groups_are_not_found() {
+#ifdef OMIT_NOTOSERIF_FONTS
+  TEST_ASSERT_NULL(findFontFamilyById(NOTOSERIF_12_FONT_ID));
+  TEST_ASSERT_NULL(findFontFamilyById(NOTOSERIF_18_FONT_ID));
+#else
+  TEST_ASSERT_NOT_NULL(findFontFamilyById(NOTOSERIF_12_FONT_ID));
+#endif
+#ifdef OMIT_OPENDYSLEXIC_FONTS
+  TEST_ASSERT_NULL(findFontFamilyById(OPENDYSLEXIC_8_FONT_ID));
+  TEST_ASSERT_NULL(findFontFamilyById(OPENDYSLEXIC_14_FONT_ID));
+#else
+  TEST_ASSERT_NOT_NULL(findFontFamilyById(OPENDYSLEXIC_8_FONT_ID));
+#endif
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_builtin_id_finds_its_own_family);
+  RUN_TEST(test_unknown_ids_are_not_found);
+  RUN_TEST(test_families_keep_their_styles);
+  RUN_TEST(test_omitted_groups_are_not_found);
+  return UNITY_END();
+}
@@ -0,0 +1,293 @@
+// Every glyph of every builtin font, drawn through the word-at-a-time glyph blitters and pixel by pixel
+// from the font bitmap, must leave the same framebuffer in every orientation. Tiled drawRuns() pages must
+// match the same runs drawn with drawText().
+#include <EpdFontFamily.h>
+#include <FontDecompressor.h>
+#include <Utf8.h>
+#include <os/graphic/Fonts.h>
+#include <os/graphic/Graphic.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+#include "../FakeDisplay.h"
+
+namespace {
+
+#define FONT_ID(id, ...) id,
+constexpr int32_t FONT_IDS[] = {BUILTIN_FONT_FAMILIES(FONT_ID)};
+#undef FONT_ID
+
+constexpr EpdFontFamily::Style STYLES[] = {EpdFontFamily::REGULAR, EpdFontFamily::BOLD, EpdFontFamily::ITALIC,
+                                           EpdFontFamily::BOLD_ITALIC};
+constexpr Graphic::Orientation ORIENTATIONS[] = {Graphic::Portrait, Graphic::LandscapeClockwise,
+                                                 Graphic::PortraitInverted, Graphic::LandscapeCounterClockwise};
+
+// Glyph cells start off-screen so the first row and column exercise clipping
+constexpr int GRID_ORIGIN = -3;
+
+// How the blitted side draws its glyphs
+enum class Mode {
+  Packed,  // straight from the font bitmap
+  Atlas,   // compressed fonts through the 1-bit glyph atlas
+  Gray,    // anti-aliased text, 2-bit fonts also writing the grayscale planes
+  White,   // white text on black
+};
+
+FakeDisplay* blitPanel;
+FakeDisplay* pixelPanel;
+Graphic* blitted;
+Graphic* reference;
+FontDecompressor decompressor;
+
+void encodeUtf8(uint32_t cp, char* out) {
+  if (cp < 0x80) {
+    *out++ = static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    *out++ = static_cast<char>(0xC0 | (cp >> 6));
+    *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    *out++ = static_cast<char>(0xE0 | (cp >> 12));
+    *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    *out++ = static_cast<char>(0xF0 | (cp >> 18));
+    *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+  }
+  *out = '\0';
+}
+
+// Pixel p of a glyph bitmap, read on its own: 2-bit pixels are inked unless white (0)
+bool isInked(const EpdFontData* data, const uint8_t* bitmap, uint32_t p) {
+  if (data->is2Bit) return (bitmap[p >> 2] >> (6 - 2 * (p & 3))) & 3;
+  return (bitmap[p >> 3] >> (7 - (p & 7))) & 1;
+}
+
+// Draw a glyph with its top left corner at (x, y) as one 1x1 box per inked pixel
+void drawReference(const EpdFontData* data, uint32_t index, int x, int y, bool black) {
+  const EpdGlyph* glyph = &data->glyph[index];
+  if (glyph->width == 0 || glyph->height == 0) return;
+  const uint8_t* bitmap =
+      data->groups ? decompressor.getBitmap(data, glyph, index) : &data->bitmap[glyph->dataOffset];
+  TEST_ASSERT_NOT_NULL(bitmap);
+
+  BoxOpts pixel;
+  pixel.fill = true;
+  pixel.black = black;
+  for (int gy = 0; gy < glyph->height; gy++) {
+    for (int gx = 0; gx < glyph->width; gx++) {
+      if (isInked(data, bitmap, static_cast<uint32_t>(gy) * glyph->width + gx)) {
+        reference->drawBox(x + gx, y + gy, 1, 1, pixel);
+      }
+    }
+  }
+}
+
+void clearPanels(bool black) {
+  BoxOpts background;
+  background.fill = true;
+  background.black = black;
+  blitted->drawBox(0, 0, blitted->getWidth(), blitted->getHeight(), background);
+  reference->drawBox(0, 0, reference->getWidth(), reference->getHeight(), background);
+}
+
+void comparePanels(int32_t id, EpdFontFamily::Style style, Graphic::Orientation orientation, uint32_t cp) {
+  char message[96];
+  snprintf(message, sizeof(message), "font %ld style %d orientation %d, page ending at U+%04lX",
+           static_cast<long>(id), style, orientation, static_cast<unsigned long>(cp));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(pixelPanel->frameBuffer, blitPanel->frameBuffer, FakeDisplay::BUFFER_SIZE,
+                                   message);
+}
+
+// Lay every glyph of one font out in a grid of cells, a page at a time, and compare each page
+void checkFont(int32_t id, const EpdFontFamily& family, EpdFontFamily::Style style,
+               Graphic::Orientation orientation, bool black) {
+  const EpdFontData* data = family.getData(style);
+  int cellW = 1, cellH = 1;
+  for (uint32_t i = 0; i < data->intervalCount; i++) {
+    const EpdUnicodeInterval& interval = data->intervals[i];
+    for (uint32_t index = interval.offset; index <= interval.offset + interval.last - interval.first; index++) {
+      cellW = std::max(cellW, data->glyph[index].width + 1);
+      cellH = std::max(cellH, data->glyph[index].height + 1);
+    }
+  }
+
+  TextOpts opts;
+  opts.font = &family;
+  opts.style = style;
+  opts.black = black;
+
+  clearPanels(!black);
+  int cx = GRID_ORIGIN, cy = GRID_ORIGIN;
+  uint32_t lastCp = 0;
+  for (uint32_t i = 0; i < data->intervalCount; i++) {
+    const EpdUnicodeInterval& interval = data->intervals[i];
+    for (uint32_t cp = interval.first; cp <= interval.last; cp++) {
+      // Marks are placed over the previous glyph, and the family may draw some code points from another
+      // glyph; neither shows this glyph at a known position
+      const uint32_t index = interval.offset + cp - interval.first;
+      const EpdGlyph* glyph = &data->glyph[index];
+      if (utf8IsCombiningMark(cp) || family.resolveGlyph(cp, style).glyph != glyph) continue;
+
+      if (cx + cellW > blitted->getWidth()) {
+        cx = GRID_ORIGIN;
+        cy += cellH;
+      }
+      if (cy + cellH > blitted->getHeight()) {
+        comparePanels(id, style, orientation, lastCp);
+        clearPanels(!black);
+        cy = GRID_ORIGIN;
+      }
+
+      char text[5];
+      encodeUtf8(cp, text);
+      blitted->drawText(text, cx - glyph->left, cy - data->ascender + glyph->top, opts);
+      drawReference(data, index, cx, cy, black);
+      cx += cellW;
+      lastCp = cp;
+    }
+  }
+  comparePanels(id, style, orientation, lastCp);
+}
+
+void checkAllFonts(Mode mode) {
+  switch (mode) {
+    case Mode::Packed:
+      blitted->setGlyphAtlasBudget(0);
+      break;
+    case Mode::Gray:
+      TEST_ASSERT_TRUE(blitted->setGrayscaleText(true));
+      break;
+    case Mode::Atlas:
+    case Mode::White:
+      break;
+  }
+
+  for (Graphic::Orientation orientation : ORIENTATIONS) {
+    blitted->setOrientation(orientation);
+    reference->setOrientation(orientation);
+    for (int32_t id : FONT_IDS) {
+      const EpdFontFamily& family = getFontFamilyById(id);
+      const EpdFontData* checked[4] = {};
+      for (EpdFontFamily::Style style : STYLES) {
+        // Missing styles fall back to regular, which is checked once
+        const EpdFontData* data = family.getData(style);
+        if (std::find(std::begin(checked), std::end(checked), data) != std::end(checked)) continue;
+        checked[style] = data;
+        checkFont(id, family, style, orientation, mode != Mode::White);
+      }
+    }
+  }
+}
+
+// A page of mixed-style runs, well over TILED_MIN_GLYPHS glyphs. Lines are not a multiple of the tile size
+// apart and start off the left edge, so glyphs straddle tile edges and the panel border.
+constexpr const char* PAGE_LINES[] = {
+    "It was the best of times, it was the worst of times, it was the age of wisdom,",
+    "it was the age of foolishness, it was the epoch of belief, it was the epoch of",
+    "incredulity, it was the season of Light, it was the season of Darkness, it was",
+    "the spring of hope, it was the winter of despair — naïve café, «Ærøskøbing».",
+};
+constexpr EpdFontFamily::Style PAGE_STYLES[] = {EpdFontFamily::REGULAR, EpdFontFamily::ITALIC,
+                                                EpdFontFamily::BOLD, EpdFontFamily::BOLD_ITALIC};
+constexpr size_t PAGE_RUNS = 40;
+
+size_t buildPage(TextRun* runs) {
+  size_t glyphs = 0;
+  for (size_t i = 0; i < PAGE_RUNS; i++) {
+    TextRun& r = runs[i];
+    r.text = PAGE_LINES[i % std::size(PAGE_LINES)];
+    r.style = PAGE_STYLES[(i / 3) % std::size(PAGE_STYLES)];
+    r.x = -7 + static_cast<int>(i % 5) * 13;
+    r.y = -11 + static_cast<int>(i) * 23;
+    glyphs += strlen(r.text);
+  }
+  return glyphs;
+}
+
+// Both panels get the same scattered boxes first, so whole-byte write-back must keep what lies under a tile
+void drawBackground(bool black) {
+  BoxOpts box;
+  box.fill = true;
+  box.black = !black;
+  for (Graphic* g : {blitted, reference}) {
+    for (int y = 0; y < g->getHeight(); y += 50) {
+      for (int x = (y / 50) % 2 * 30; x < g->getWidth(); x += 60) g->drawBox(x, y, 29, 17, box);
+    }
+  }
+}
+
+void checkTiledPage(bool black, bool clipped) {
+  TextRun runs[PAGE_RUNS];
+  TEST_ASSERT_GREATER_OR_EQUAL(Graphic::TILED_MIN_GLYPHS, buildPage(runs));
+  const EpdFontFamily& family = getFontFamilyById(NOTOSANS_14_FONT_ID);
+
+  for (Graphic::Orientation orientation : ORIENTATIONS) {
+    blitted->setOrientation(orientation);
+    reference->setOrientation(orientation);
+    clearPanels(!black);
+    drawBackground(black);
+    if (clipped) {
+      TEST_ASSERT_TRUE(blitted->pushClip(37, 91, 301, 213));
+      TEST_ASSERT_TRUE(reference->pushClip(37, 91, 301, 213));
+    }
+
+    blitted->drawRuns(runs, PAGE_RUNS, family, black);
+    for (const TextRun& r : runs) reference->drawText(r.text, r.x, r.y, TextOpts{&family, black, r.style});
+
+    if (clipped) {
+      blitted->popClip();
+      reference->popClip();
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "orientation %d, %s, %s", orientation, black ? "black" : "white",
+             clipped ? "clipped" : "unclipped");
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(pixelPanel->frameBuffer, blitPanel->frameBuffer, FakeDisplay::BUFFER_SIZE,
+                                     message);
+  }
+}
+
+}  // namespace
+
+void setUp() {
+  blitPanel = new FakeDisplay();
+  pixelPanel = new FakeDisplay();
+  blitted = new Graphic(*blitPanel);
+  reference = new Graphic(*pixelPanel);
+}
+
+void tearDown() {
+  delete blitted;
+  delete reference;
+  delete blitPanel;
+  delete pixelPanel;
+  decompressor.clearCache();
+}
+
+void test_packed_glyphs_match_per_pixel() { checkAllFonts(Mode::Packed); }
+void test_atlas_glyphs_match_per_pixel() { checkAllFonts(Mode::Atlas); }
+void test_gray_glyphs_match_per_pixel() { checkAllFonts(Mode::Gray); }
+void test_white_glyphs_match_per_pixel() { checkAllFonts(Mode::White); }
+
+// drawRuns() bins large pages into tiles; the result must equal drawing every run with drawText()
+void test_tiled_runs_match_draw_text() {
+  for (bool black : {true, false}) {
+    checkTiledPage(black, false);
+    checkTiledPage(black, true);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_packed_glyphs_match_per_pixel);
+  RUN_TEST(test_atlas_glyphs_match_per_pixel);
+  RUN_TEST(test_gray_glyphs_match_per_pixel);
+  RUN_TEST(test_white_glyphs_match_per_pixel);
+  RUN_TEST(test_tiled_runs_match_draw_text);
+  return UNITY_END();
+}
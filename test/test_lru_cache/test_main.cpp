@@ -0,0 +1,214 @@
+#include <os/graphic/Fonts.h>
+#include <os/graphic/GlyphAtlas.h>
+#include <os/graphic/Graphic.h>
+#include <os/graphic/LruCache.h>
+#include <unity.h>
+
+#include <cstring>
+#include <new>
+
+#include "../FakeDisplay.h"
+
+namespace {
+
+int liveEntries = 0;
+
+struct TestEntry : LruEntry<TestEntry> {
+  int key;
+  explicit TestEntry(int key) : key(key) { liveEntries++; }
+  ~TestEntry() { liveEntries--; }
+};
+
+// Four buckets, so keys 0, 4, 8... share a chain
+using TestCache = LruCache<TestEntry, 4>;
+
+bool add(TestCache& cache, int key, uint32_t size) {
+  if (!cache.reserve(size)) return false;
+  void* memory = malloc(sizeof(TestEntry));
+  TEST_ASSERT_NOT_NULL(memory);
+  cache.add(new (memory) TestEntry(key), static_cast<uint32_t>(key), size);
+  return true;
+}
+
+TestEntry* find(TestCache& cache, int key) {
+  return cache.find(static_cast<uint32_t>(key), [key](const TestEntry& e) { return e.key == key; });
+}
+
+bool contains(const TestCache& cache, int key) {
+  return cache.peek(static_cast<uint32_t>(key), [key](const TestEntry& e) { return e.key == key; }) != nullptr;
+}
+
+FakeDisplay* panel;
+Graphic* gfx;
+
+TextOpts uiText() {
+  TextOpts opts;
+  opts.font = &getFontFamilyById(UI_12_FONT_ID);
+  return opts;
+}
+
+}  // namespace
+
+void setUp() {
+  liveEntries = 0;
+  panel = new FakeDisplay();
+  gfx = new Graphic(*panel);
+}
+
+void tearDown() {
+  delete gfx;
+  delete panel;
+}
+
+void test_least_recently_used_entry_is_evicted() {
+  {
+    TestCache cache(100);
+    for (int key = 0; key < 4; key++) TEST_ASSERT_TRUE(add(cache, key, 25));
+    TEST_ASSERT_EQUAL(100, cache.getStats().bytes);
+
+    // Touch 0, so 1 is now the least recently used
+    TEST_ASSERT_NOT_NULL(find(cache, 0));
+    TEST_ASSERT_TRUE(add(cache, 4, 25));
+    TEST_ASSERT_FALSE(contains(cache, 1));
+    TEST_ASSERT_TRUE(contains(cache, 0));
+    TEST_ASSERT_TRUE(contains(cache, 4));
+    TEST_ASSERT_EQUAL(1, cache.getStats().evictions);
+    TEST_ASSERT_EQUAL(4, cache.getStats().entries);
+
+    // A big entry evicts as many as it needs, oldest first: 2 and 3
+    TEST_ASSERT_TRUE(add(cache, 5, 50));
+    TEST_ASSERT_FALSE(contains(cache, 2));
+    TEST_ASSERT_FALSE(contains(cache, 3));
+    TEST_ASSERT_TRUE(contains(cache, 0));
+    TEST_ASSERT_EQUAL(3, liveEntries);
+  }
+  // The cache destroys what it still holds
+  TEST_ASSERT_EQUAL(0, liveEntries);
+}
+
+void test_colliding_hashes_are_told_apart_by_match() {
+  TestCache cache(1000);
+  // Same bucket, same hash
+  TEST_ASSERT_TRUE(cache.reserve(10));
+  cache.add(new (malloc(sizeof(TestEntry))) TestEntry(1), 7, 10);
+  TEST_ASSERT_TRUE(cache.reserve(10));
+  cache.add(new (malloc(sizeof(TestEntry))) TestEntry(2), 7, 10);
+
+  for (int key = 1; key <= 2; key++) {
+    TestEntry* e = cache.find(7, [key](const TestEntry& entry) { return entry.key == key; });
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL(key, e->key);
+  }
+  TEST_ASSERT_NULL(cache.find(7, [](const TestEntry& entry) { return entry.key == 3; }));
+  TEST_ASSERT_EQUAL(2, cache.getStats().hits);
+  TEST_ASSERT_EQUAL(1, cache.getStats().misses);
+}
+
+void test_peek_leaves_order_and_stats_alone() {
+  TestCache cache(50);
+  add(cache, 0, 25);
+  add(cache, 1, 25);
+  TEST_ASSERT_TRUE(contains(cache, 0));
+  TEST_ASSERT_EQUAL(0, cache.getStats().hits);
+
+  // 0 is still the least recently used
+  add(cache, 2, 25);
+  TEST_ASSERT_FALSE(contains(cache, 0));
+  TEST_ASSERT_TRUE(contains(cache, 1));
+}
+
+void test_budget_limits_entries() {
+  TestCache cache(100);
+  TEST_ASSERT_FALSE(cache.reserve(101));
+  for (int key = 0; key < 8; key++) add(cache, key, 20);
+  TEST_ASSERT_EQUAL(5, cache.getStats().entries);
+
+  // Shrinking evicts down to the new budget, oldest first
+  cache.setBudget(45);
+  TEST_ASSERT_EQUAL(2, cache.getStats().entries);
+  TEST_ASSERT_EQUAL(40, cache.getStats().bytes);
+  TEST_ASSERT_TRUE(contains(cache, 6));
+  TEST_ASSERT_TRUE(contains(cache, 7));
+
+  cache.setBudget(0);
+  TEST_ASSERT_EQUAL(0, cache.getStats().entries);
+  TEST_ASSERT_EQUAL(0, liveEntries);
+  TEST_ASSERT_FALSE(cache.reserve(1));
+}
+
+void test_glyph_atlas_thresholds_and_evicts() {
+  const EpdFontData* data = getFontFamilyById(NOTOSANS_14_FONT_ID).getData();
+  // Any 2-bit font will do; the glyph is made up so the expected mask is known
+  static const uint8_t bitmap[] = {0x1B, 0x00, 0xC0};  // pixels 0,1,2,3 / 0,0,0,0 / 3,0,0,0
+  EpdGlyph glyph = {};
+  glyph.width = 4;
+  glyph.height = 3;
+  glyph.dataLength = sizeof(bitmap);
+
+  GlyphAtlas atlas;
+  const uint8_t* mask = atlas.insert(data, 1, &glyph, bitmap);
+  TEST_ASSERT_NOT_NULL(mask);
+  TEST_ASSERT_EQUAL_HEX8(0x70, mask[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x00, mask[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x80, mask[2]);
+
+  TEST_ASSERT_TRUE(atlas.contains(data, 1));
+  TEST_ASSERT_FALSE(atlas.contains(data, 2));
+  TEST_ASSERT_EQUAL_PTR(mask, atlas.find(data, 1));
+  TEST_ASSERT_EQUAL(1, atlas.getStats().hits);
+
+  atlas.setBudget(0);
+  TEST_ASSERT_FALSE(atlas.contains(data, 1));
+  TEST_ASSERT_NULL(atlas.insert(data, 1, &glyph, bitmap));
+}
+
+// Repeated labels are blits from the label cache, and look exactly like drawText()
+void test_label_cache_hits_match_draw_text() {
+  static uint8_t expected[FakeDisplay::BUFFER_SIZE];
+  const TextOpts opts = uiText();
+  gfx->drawText("Settings", 40, 100, opts);
+  memcpy(expected, panel->frameBuffer, sizeof(expected));
+
+  BoxOpts white;
+  white.fill = true;
+  white.black = false;
+  for (int i = 0; i < 3; i++) {
+    gfx->drawBox(0, 0, gfx->getWidth(), gfx->getHeight(), white);
+    gfx->drawLabel("Settings", 40, 100, opts);
+    TEST_ASSERT_EQUAL_MEMORY(expected, panel->frameBuffer, sizeof(expected));
+  }
+  TEST_ASSERT_EQUAL(1, gfx->getLabelCache().getStats().misses);
+  TEST_ASSERT_EQUAL(2, gfx->getLabelCache().getStats().hits);
+  TEST_ASSERT_EQUAL(1, gfx->getLabelCache().getStats().entries);
+}
+
+// Only label paths fill the shape cache; bulk text measurement and drawing leave it alone
+void test_shape_cache_is_filled_by_labels_only() {
+  const TextOpts opts = uiText();
+  const int width = gfx->getTextWidth("Back", opts);
+  gfx->drawText("Back", 10, 10, opts);
+  TEST_ASSERT_EQUAL(0, gfx->getShapeCache().getStats().entries);
+  TEST_ASSERT_EQUAL(0, gfx->getShapeCache().getStats().misses);
+
+  TEST_ASSERT_EQUAL(width, gfx->getLabelWidth("Back", opts));
+  TEST_ASSERT_EQUAL(1, gfx->getShapeCache().getStats().entries);
+  TEST_ASSERT_EQUAL(width, gfx->getLabelWidth("Back", opts));
+  TEST_ASSERT_EQUAL(1, gfx->getShapeCache().getStats().hits);
+
+  gfx->clearGlyphCache();
+  TEST_ASSERT_EQUAL(0, gfx->getShapeCache().getStats().entries);
+  TEST_ASSERT_EQUAL(0, gfx->getLabelCache().getStats().entries);
+  TEST_ASSERT_EQUAL(0, gfx->getGlyphAtlas().getStats().entries);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_least_recently_used_entry_is_evicted);
+  RUN_TEST(test_colliding_hashes_are_told_apart_by_match);
+  RUN_TEST(test_peek_leaves_order_and_stats_alone);
+  RUN_TEST(test_budget_limits_entries);
+  RUN_TEST(test_glyph_atlas_thresholds_and_evicts);
+  RUN_TEST(test_label_cache_hits_match_draw_text);
+  RUN_TEST(test_shape_cache_is_filled_by_labels_only);
+  return UNITY_END();
+}
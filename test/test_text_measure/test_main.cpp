@@ -0,0 +1,127 @@
+// EpdFontFamily::measureAdvances() against the pen positions drawing uses
+#include <os/graphic/Fonts.h>
+#include <os/graphic/Graphic.h>
+#include <unity.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../FakeDisplay.h"
+
+namespace {
+
+FakeDisplay* panel;
+Graphic* gfx;
+
+const EpdFontFamily& reading() { return getFontFamilyById(NOTOSANS_14_FONT_ID); }
+
+// getTextWidth() is the ink width, so the reference is the pen: a zero width space appended to the text is
+// placed by the same layout walk drawText() uses, exactly where the text's advances end
+int penAfter(const char* text, EpdFontFamily::Style style) {
+  const std::string probe = std::string(text) + "\xE2\x80\x8B";
+  ShapedRun run;
+  TEST_ASSERT_TRUE(gfx->shapeText(probe.c_str(), TextOpts{&reading(), true, style}, &run));
+  return (run.end() - 1)->x;
+}
+
+std::vector<int32_t> measure(const char* text, EpdFontFamily::Style style, int* width) {
+  std::vector<int32_t> prefixWidths(strlen(text) + 1, -1);
+  *width = reading().measureAdvances(text, style, prefixWidths.data());
+  return prefixWidths;
+}
+
+bool isContinuationByte(char c) { return (static_cast<uint8_t>(c) & 0xC0) == 0x80; }
+
+// No two letters here form a ligature, so every prefix can be measured on its own
+const char* const PLAIN_TEXTS[] = {
+    "AVATAR Wo Ty Yo LT P. 'quoted'",
+    "Ærøskøbing, naïve café — 12 ½ km",
+    "Прощай, «мир»",
+    "e\xCC\x81te\xCC\x81 over combining marks",
+};
+
+}  // namespace
+
+void setUp() {
+  panel = new FakeDisplay();
+  gfx = new Graphic(*panel);
+}
+
+void tearDown() {
+  delete gfx;
+  delete panel;
+}
+
+void test_width_matches_drawing_pen() {
+  const char* texts[] = {"Hello, world", "AVATAR Wo Ty", "office staff affix", "naïve café", "x"};
+  for (const auto style : {EpdFontFamily::REGULAR, EpdFontFamily::BOLD, EpdFontFamily::ITALIC}) {
+    for (const char* text : texts) {
+      int width;
+      const std::vector<int32_t> prefixWidths = measure(text, style, &width);
+      TEST_ASSERT_EQUAL_MESSAGE(penAfter(text, style), width, text);
+      TEST_ASSERT_EQUAL(width, prefixWidths.back());
+      TEST_ASSERT_EQUAL(0, prefixWidths.front());
+    }
+  }
+}
+
+void test_prefixes_match_standalone_measurement() {
+  for (const char* text : PLAIN_TEXTS) {
+    int width;
+    const std::vector<int32_t> prefixWidths = measure(text, EpdFontFamily::REGULAR, &width);
+    const size_t length = strlen(text);
+    for (size_t i = 1; i <= length; i++) {
+      if (i < length && isContinuationByte(text[i])) {
+        // Inside a multi-byte character: the width before it
+        size_t start = i - 1;
+        while (isContinuationByte(text[start])) start--;
+        TEST_ASSERT_EQUAL(prefixWidths[start], prefixWidths[i]);
+        continue;
+      }
+      const std::string prefix(text, i);
+      int alone;
+      measure(prefix.c_str(), EpdFontFamily::REGULAR, &alone);
+      TEST_ASSERT_EQUAL_MESSAGE(alone, prefixWidths[i], prefix.c_str());
+      TEST_ASSERT_GREATER_OR_EQUAL(prefixWidths[i - 1], prefixWidths[i]);
+    }
+  }
+}
+
+void test_ligature_bytes_repeat_width_before_it() {
+  // "ffi" becomes one glyph, so the cuts after "f" and "ff" fall inside it
+  const char* text = "affix";
+  int width;
+  const std::vector<int32_t> prefixWidths = measure(text, EpdFontFamily::REGULAR, &width);
+  TEST_ASSERT_GREATER_THAN(0, prefixWidths[1]);
+  TEST_ASSERT_EQUAL(prefixWidths[1], prefixWidths[2]);
+  TEST_ASSERT_EQUAL(prefixWidths[1], prefixWidths[3]);
+  TEST_ASSERT_GREATER_THAN(prefixWidths[3], prefixWidths[4]);
+  TEST_ASSERT_GREATER_THAN(prefixWidths[4], prefixWidths[5]);
+
+  int ligature;
+  measure("aﬃ", EpdFontFamily::REGULAR, &ligature);
+  TEST_ASSERT_EQUAL(ligature, prefixWidths[4]);
+}
+
+// A long paragraph passes 32767 px; the widths must keep growing instead of wrapping
+void test_long_text_widths_stay_monotonic() {
+  std::string text;
+  while (text.size() < 6000) text += "The quick brown fox jumps over the lazy dog. ";
+  int width;
+  const std::vector<int32_t> prefixWidths = measure(text.c_str(), EpdFontFamily::REGULAR, &width);
+  TEST_ASSERT_GREATER_THAN(32767, width);
+  TEST_ASSERT_EQUAL(width, prefixWidths.back());
+  for (size_t i = 1; i < prefixWidths.size(); i++) {
+    TEST_ASSERT_GREATER_OR_EQUAL(prefixWidths[i - 1], prefixWidths[i]);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_width_matches_drawing_pen);
+  RUN_TEST(test_prefixes_match_standalone_measurement);
+  RUN_TEST(test_ligature_bytes_repeat_width_before_it);
+  RUN_TEST(test_long_text_widths_stay_monotonic);
+  return UNITY_END();
+}